@@ -0,0 +1,32 @@
+#include <cstdlib>
+#include <new>
+
+#include "arena.h"
+
+void *Arena::alloc_slow(size_t size) {
+	// an empty arena starts with its first chunk
+	if (cur < chunks.size())
+		cur++;
+	used = 0;
+
+	// skip chunks that are too small for this object
+	while (cur < chunks.size() && chunks[cur].second < size)
+		cur++;
+
+	if (cur == chunks.size()) {
+		size_t chunk_size = size > ARENA_CHUNK_SIZE ? size : ARENA_CHUNK_SIZE;
+		char *p = (char *) malloc(chunk_size);
+		if (p == nullptr)
+			throw bad_alloc();
+
+		chunks.emplace_back(p, chunk_size);
+	}
+
+	used = size;
+	return chunks[cur].first;
+}
+
+Arena::~Arena() {
+	for (auto chunk: chunks)
+		free(chunk.first);
+}
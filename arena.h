@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+using namespace std;
+
+// size of the memory blocks the arena gets from malloc
+#define ARENA_CHUNK_SIZE (1 << 20)
+
+// bump allocator for the objects created while transforming the graph
+//
+// objects are released in the reverse order they were allocated in, so a
+// graph_snapshot only has to remember the current position. Restoring it
+// gives back all memory allocated since in O(1). Destructors are not run
+// by the arena, call them before releasing the memory
+class Arena {
+public:
+	struct mark {
+		size_t chunk;
+		size_t used;
+	};
+
+	void *alloc(size_t size) {
+		size = (size + 15) & ~(size_t) 15;
+
+		if (cur < chunks.size() && used + size <= chunks[cur].second) {
+			void *p = chunks[cur].first + used;
+			used += size;
+			return p;
+		}
+
+		return alloc_slow(size);
+	}
+
+	mark get_mark() const {
+		return mark{cur, used};
+	}
+
+	// free everything allocated since m was taken
+	void release(const mark &m) {
+		cur  = m.chunk;
+		used = m.used;
+	}
+
+	Arena() {};
+	~Arena();
+
+	Arena(const Arena &) = delete;
+	Arena &operator=(const Arena &) = delete;
+
+private:
+	// memory and size of the chunks, the ones after cur are unused
+	vector< pair<char *, size_t> > chunks;
+	size_t cur  = 0;
+	size_t used = 0;
+
+	void *alloc_slow(size_t size);
+};
+
+template<typename T, typename... Args>
+T *arena_new(Arena &A, Args&&... args) {
+	return new (A.alloc(sizeof(T))) T(std::forward<Args>(args)...);
+}
@@ -0,0 +1,381 @@
+// Benchmark driver: runs the solver over a directory of instances, writes
+// one CSV line per instance and compares it against a baseline CSV.
+//
+// Usage: bench_runner [-r reps] [-o out.csv] [-b baseline.csv] [-t threshold]
+//                     [-c config.conf] [-T seconds] solver dir
+//
+// -T kills a run with SIGKILL once it took that long, the instance then
+// counts as timed out and its remaining repetitions are skipped.
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <csignal>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+
+using namespace std;
+
+struct bench_run {
+	double wall = 0;        // s
+	long rss = 0;           // peak RSS in KB
+	long long steps = -1;   // c recursive steps
+	long long kernel_n = -1; // c n: ... -> kernel_n
+	long long kernel_m = -1; // c m: ... -> kernel_m
+	long long vc = -1;      // s vc n vc
+	int status = 0;
+	bool timed_out = false;
+};
+
+struct bench_row {
+	string instance;
+	size_t runs = 0;
+	double wall_min = 0;
+	double wall_median = 0;
+	long rss = 0;
+	long long steps = -1;
+	long long kernel_n = -1;
+	long long kernel_m = -1;
+	long long vc = -1;
+	bool failed = false;
+	bool timed_out = false;
+};
+
+static const char *csv_header = "instance,runs,wall_min,wall_median,rss_kb,recursive_steps,kernel_n,kernel_m,vc,failed,timed_out";
+
+// value after the "->" of a line, or after its prefix
+static long long line_value(const string &line, size_t pos) {
+	size_t arrow = line.find("->", pos);
+	if (arrow != string::npos)
+		pos = arrow + 2;
+	return strtoll(line.c_str() + pos, nullptr, 10);
+}
+
+static void parse_output(const string &out, bench_run &r) {
+	istringstream in(out);
+	string line;
+	while (getline(in, line)) {
+		if (line.compare(0, 19, "c recursive steps: ") == 0)
+			r.steps = strtoll(line.c_str() + 19, nullptr, 10);
+		else if (line.compare(0, 5, "c n: ") == 0)
+			r.kernel_n = line_value(line, 5);
+		else if (line.compare(0, 5, "c m: ") == 0)
+			r.kernel_m = line_value(line, 5);
+		else if (line.compare(0, 5, "s vc ") == 0) {
+			istringstream s(line.substr(5));
+			long long n;
+			s >> n >> r.vc;
+		}
+	}
+}
+
+// runs solver [config] < instance once, kills it after limit seconds if
+// limit > 0
+static bool run_solver(const string &solver, const string &config, const string &instance, double limit, bench_run &r) {
+	int in = open(instance.c_str(), O_RDONLY);
+	if (in < 0) {
+		cerr << "cannot open " << instance << ": " << strerror(errno) << endl;
+		return false;
+	}
+
+	int fds[2];
+	if (pipe(fds) < 0) {
+		close(in);
+		return false;
+	}
+
+	auto start = chrono::steady_clock::now();
+	pid_t pid = fork();
+	if (pid < 0) {
+		close(in);
+		close(fds[0]);
+		close(fds[1]);
+		return false;
+	}
+
+	if (pid == 0) {
+		dup2(in, STDIN_FILENO);
+		dup2(fds[1], STDOUT_FILENO);
+		close(in);
+		close(fds[0]);
+		close(fds[1]);
+
+		if (config.empty())
+			execl(solver.c_str(), solver.c_str(), (char *) nullptr);
+		else
+			execl(solver.c_str(), solver.c_str(), config.c_str(), (char *) nullptr);
+		_exit(127);
+	}
+
+	close(in);
+	close(fds[1]);
+
+	// the solver writes its output at the end, so wait on the pipe until it
+	// is closed or the limit is up
+	string out;
+	char buf[1 << 16];
+	for (;;) {
+		int timeout = -1;
+		if (limit > 0) {
+			double left = limit - chrono::duration<double>(chrono::steady_clock::now() - start).count();
+			if (left <= 0) {
+				kill(pid, SIGKILL);
+				r.timed_out = true;
+				break;
+			}
+			timeout = (int) (left * 1000) + 1;
+		}
+
+		struct pollfd p = { fds[0], POLLIN, 0 };
+		int ready = poll(&p, 1, timeout);
+		if (ready < 0 && errno != EINTR)
+			break;
+		if (ready <= 0)
+			continue;
+
+		ssize_t len = read(fds[0], buf, sizeof(buf));
+		if (len < 0 && errno == EINTR)
+			continue;
+		if (len <= 0)
+			break;
+		out.append(buf, len);
+	}
+	close(fds[0]);
+
+	struct rusage usage;
+	while (wait4(pid, &r.status, 0, &usage) < 0) {
+		if (errno != EINTR)
+			return false;
+	}
+	r.wall = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+	r.rss  = usage.ru_maxrss;
+
+	if (!r.timed_out)
+		parse_output(out, r);
+	return true;
+}
+
+static vector<string> list_instances(const string &dir) {
+	vector<string> files;
+	DIR *d = opendir(dir.c_str());
+	if (d == nullptr)
+		return files;
+
+	while (struct dirent *e = readdir(d)) {
+		string name = e->d_name;
+		if (name.size() > 3 && (name.compare(name.size() - 3, 3, ".gr") == 0
+		    || (name.size() > 4 && name.compare(name.size() - 4, 4, ".dimacs") == 0)))
+			files.push_back(name);
+	}
+	closedir(d);
+
+	sort(files.begin(), files.end());
+	return files;
+}
+
+static bench_row bench_instance(const string &solver, const string &config, const string &dir, const string &name, size_t reps, double limit) {
+	bench_row row;
+	row.instance = name;
+
+	vector<double> walls;
+	for (size_t i = 0; i < reps; i++) {
+		bench_run r;
+		bool ok = run_solver(solver, config, dir + "/" + name, limit, r);
+		if (ok && r.timed_out) {
+			row.timed_out = true;
+			row.rss = max(row.rss, r.rss);
+			break;
+		}
+		if (!ok || !WIFEXITED(r.status)
+		    || WEXITSTATUS(r.status) != 0 || r.vc < 0) {
+			row.failed = true;
+			break;
+		}
+
+		// the search is deterministic up to the parallel parts, keep the
+		// first run's counters and the worst memory
+		if (i == 0) {
+			row.steps    = r.steps;
+			row.kernel_n = r.kernel_n;
+			row.kernel_m = r.kernel_m;
+			row.vc       = r.vc;
+		}
+		else if (r.vc != row.vc) {
+			cerr << name << ": cover size " << r.vc << " differs from " << row.vc << endl;
+			row.failed = true;
+		}
+		row.rss = max(row.rss, r.rss);
+		walls.push_back(r.wall);
+	}
+
+	row.runs = walls.size();
+	if (!walls.empty()) {
+		sort(walls.begin(), walls.end());
+		row.wall_min    = walls.front();
+		row.wall_median = walls[walls.size() / 2];
+	}
+	return row;
+}
+
+static void write_row(ostream &out, const bench_row &r) {
+	out << r.instance << "," << r.runs << "," << r.wall_min << "," << r.wall_median << "," << r.rss
+	    << "," << r.steps << "," << r.kernel_n << "," << r.kernel_m << "," << r.vc << "," << (r.failed ? 1 : 0) << "," << (r.timed_out ? 1 : 0) << "\n";
+}
+
+static map<string, bench_row> read_csv(const string &file) {
+	map<string, bench_row> rows;
+	ifstream in(file);
+	string line;
+	getline(in, line); // header
+	while (getline(in, line)) {
+		vector<string> f;
+		istringstream s(line);
+		string field;
+		while (getline(s, field, ','))
+			f.push_back(field);
+		if (f.size() < 10)
+			continue;
+
+		bench_row r;
+		r.instance    = f[0];
+		r.runs        = stoull(f[1]);
+		r.wall_min    = stod(f[2]);
+		r.wall_median = stod(f[3]);
+		r.rss         = stol(f[4]);
+		r.steps       = stoll(f[5]);
+		r.kernel_n    = stoll(f[6]);
+		r.kernel_m    = stoll(f[7]);
+		r.vc          = stoll(f[8]);
+		r.failed      = f[9] == "1";
+		r.timed_out   = f.size() > 10 && f[10] == "1"; // older files lack it
+		rows[r.instance] = r;
+	}
+	return rows;
+}
+
+// true if now is more than threshold worse than base, times below min_abs
+// are noise
+static bool worse(double now, double base, double threshold, double min_abs) {
+	return now > base * (1 + threshold) && now - base > min_abs;
+}
+
+// returns the number of regressions
+static size_t compare(const vector<bench_row> &rows, const map<string, bench_row> &baseline, double threshold) {
+	size_t regressions = 0;
+	for (const bench_row &r: rows) {
+		auto it = baseline.find(r.instance);
+		if (it == baseline.end())
+			continue;
+		const bench_row &b = it->second;
+
+		vector<string> why;
+		if (r.failed && !b.failed)
+			why.push_back("failed");
+		if (r.timed_out && !b.timed_out)
+			why.push_back("timed out");
+
+		// a timed out side has no numbers to compare
+		if (!r.timed_out && !b.timed_out) {
+			if (!r.failed && !b.failed && r.vc != b.vc)
+				why.push_back("cover " + to_string(b.vc) + " -> " + to_string(r.vc));
+			if (worse(r.wall_median, b.wall_median, threshold, 0.05))
+				why.push_back("time " + to_string(b.wall_median) + " -> " + to_string(r.wall_median) + " s");
+			if (worse(r.rss, b.rss, threshold, 1024))
+				why.push_back("rss " + to_string(b.rss) + " -> " + to_string(r.rss) + " KB");
+			if (b.steps >= 0 && worse(r.steps, b.steps, threshold, 0))
+				why.push_back("steps " + to_string(b.steps) + " -> " + to_string(r.steps));
+			if (b.kernel_n >= 0 && r.kernel_n > b.kernel_n)
+				why.push_back("kernel " + to_string(b.kernel_n) + " -> " + to_string(r.kernel_n));
+		}
+
+		if (why.empty())
+			continue;
+
+		regressions++;
+		cout << "REGRESSION " << r.instance << ":";
+		for (size_t i = 0; i < why.size(); i++)
+			cout << (i > 0 ? ", " : " ") << why[i];
+		cout << endl;
+	}
+	return regressions;
+}
+
+static void usage(const char *argv0) {
+	cerr << "Usage: " << argv0 << " [-r reps] [-o out.csv] [-b baseline.csv] [-t threshold] [-c config.conf] [-T seconds] solver dir" << endl;
+	exit(2);
+}
+
+int main(int argc, char **argv) {
+	size_t reps = 3;
+	string out_file = "bench.csv";
+	string baseline_file;
+	string config;
+	double threshold = 0.10;
+	double limit = 0;
+
+	int opt;
+	while ((opt = getopt(argc, argv, "r:o:b:t:c:T:")) != -1) {
+		switch (opt) {
+		case 'r': reps = stoull(optarg); break;
+		case 'o': out_file = optarg; break;
+		case 'b': baseline_file = optarg; break;
+		case 't': threshold = stod(optarg); break;
+		case 'c': config = optarg; break;
+		case 'T': limit = stod(optarg); break;
+		default: usage(argv[0]);
+		}
+	}
+	if (argc - optind != 2 || reps == 0)
+		usage(argv[0]);
+
+	string solver = argv[optind];
+	string dir    = argv[optind + 1];
+
+	vector<string> instances = list_instances(dir);
+	if (instances.empty()) {
+		cerr << "no .gr instances in " << dir << endl;
+		return 2;
+	}
+
+	ofstream out(out_file);
+	out << csv_header << "\n";
+
+	vector<bench_row> rows;
+	for (const string &name: instances) {
+		bench_row r = bench_instance(solver, config, dir, name, reps, limit);
+		write_row(out, r);
+		out.flush();
+
+		string result = r.failed ? "FAILED" : r.timed_out ? "TIMEOUT" : to_string(r.wall_median) + " s";
+		cout << name << ": " << result
+		     << ", vc " << r.vc << ", steps " << r.steps << ", rss " << r.rss << " KB" << endl;
+		rows.push_back(r);
+	}
+
+	size_t failed = count_if(rows.begin(), rows.end(), [](const bench_row &r) { return r.failed; });
+	size_t timed_out = count_if(rows.begin(), rows.end(), [](const bench_row &r) { return r.timed_out; });
+	if (timed_out > 0)
+		cout << timed_out << " instances timed out after " << limit << " s" << endl;
+
+	if (baseline_file.empty() || access(baseline_file.c_str(), R_OK) != 0) {
+		if (!baseline_file.empty())
+			cout << "no baseline " << baseline_file << ", nothing to compare" << endl;
+		return failed > 0;
+	}
+
+	size_t regressions = compare(rows, read_csv(baseline_file), threshold);
+	cout << regressions << " regressions, " << failed << " failures against " << baseline_file << endl;
+	return regressions > 0 || failed > 0;
+}
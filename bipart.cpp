@@ -5,9 +5,14 @@
 #include <cmath>
 
 #include "graph.h"
+#include "bipart.h"
+#include "csr.h"
+#include "flow.h"
+#include "stats.h"
 
 size_t LP_BOUND_CUTOFF = 10000000.0;
 size_t INFTY = numeric_limits<size_t>::max();
+lp_engine LP_ENGINE = LP_ENGINE_HK;
 
 bool lp_bound_check_feasability(Graph &G) {
 	float val = sqrt(G.V.size());
@@ -19,145 +24,231 @@ bool lp_bound_check_feasability(Graph &G) {
 	return true;
 }
 
-Vertex NIL(0, "NIL");
+Vertex NIL((size_t) -1, NO_LABEL);
 
-Vertex *&Pair_U(Vertex *u) {
-	return u->hk_pair[0];
+inline lp_data &LP(Graph &G, Vertex *v) {
+	return G.lp[v->id + 1];
 }
 
-Vertex *&Pair_V(Vertex *v) {
-	return v->hk_pair[1];
+inline Vertex *&Pair_U(Graph &G, Vertex *u) {
+	return LP(G, u).hk_pair[0];
 }
 
-size_t &Dist(Vertex *a) {
-	return a->hk_dist;
+inline Vertex *&Pair_V(Graph &G, Vertex *v) {
+	return LP(G, v).hk_pair[1];
+}
+
+inline size_t &Dist(Graph &G, Vertex *a) {
+	return LP(G, a).hk_dist;
+}
+
+/* change the partner of v on the left (side 0) or right (side 1)
+ * inside a snapshot the old partner goes on the trail, so restore_snapshot
+ * gives the next branch the matching of its parent to start from
+ */
+inline void set_pair(Graph &G, Vertex *v, int side, Vertex *p) {
+	Vertex *&pair = LP(G, v).hk_pair[side];
+
+	if (G.snapshots > 0 && !G.undoing)
+		trail_push(G, side == 0 ? TRAIL_PAIR_U : TRAIL_PAIR_V, v, pair);
+	pair = p;
+}
+
+// undo a set_pair
+void bp_restore_pair(Graph &G, Vertex *v, int side, Vertex *p) {
+	LP(G, v).hk_pair[side] = p;
 }
 
 /* whenever we remove a vertex from the graph call this function */
 void bp_vertex_delete_callback(Graph &G, Vertex *v) {
-	Dist(v) = INFTY;
+	if (G.lp.empty())
+		return;
+
+	Dist(G, v) = INFTY;
 
-	Vertex *p = Pair_U(v);
+	Vertex *p = Pair_U(G, v);
 	if (p != &NIL) {
-		Pair_V(p) = &NIL;
-		Pair_U(v) = &NIL;
+		set_pair(G, p, 1, &NIL);
+		set_pair(G, v, 0, &NIL);
 		G.matching--;
 	}
 
-	p = Pair_V(v);
+	p = Pair_V(G, v);
 	if (p != &NIL) {
-		Pair_V(v) = &NIL;
-		Pair_U(p) = &NIL;
+		set_pair(G, v, 1, &NIL);
+		set_pair(G, p, 0, &NIL);
 		G.matching--;
 	}
 }
 
 /* whenever we remove an edge from the graph call this function */
 void bp_edge_delete_callback(Graph &G, Edge *e) {
+	if (G.lp.empty())
+		return;
+
 	Vertex *a = e->end[0];
 	Vertex *b = e->end[1];
 
-	Vertex *p = Pair_U(a);
+	Vertex *p = Pair_U(G, a);
 	if (p == b) {
-		Pair_V(p) = &NIL;
-		Pair_U(a) = &NIL;
+		set_pair(G, p, 1, &NIL);
+		set_pair(G, a, 0, &NIL);
 		G.matching--;
 	}
 
-	p = Pair_V(a);
+	p = Pair_V(G, a);
 	if (p == b) {
-		Pair_V(a) = &NIL;
-		Pair_U(p) = &NIL;
+		set_pair(G, a, 1, &NIL);
+		set_pair(G, p, 0, &NIL);
 		G.matching--;
 	}
 }
 
 /* whenever we add a newly CREATED vertex call this function */
 void bp_vertex_create_callback(Graph &G, Vertex *v) {
-	Pair_U(v) = &NIL;
-	Pair_V(v) = &NIL;
-	v->bp_vc[0] = false;
-	v->bp_vc[1] = false;
+	if (G.lp.empty())
+		return;
+
+	if (G.lp.size() < v->id + 2)
+		G.lp.resize(v->id + 2);
+	LP(G, v) = lp_data();
 }
 
+/* layer G.V from all free left vertices and mark the right vertices reached
+ * by alternating paths. This is O(n + m) per call even if the matching from
+ * the trail needs few augmentations: bp_vertex_cover reads hk_alternating and
+ * bp_vc of every vertex, so they can't be seeded from the changed ones only
+ */
 bool BFS(Graph &G) {
-	static queue<Vertex *> Q;
+	static thread_local queue<Vertex *> Q;
 	for (auto it = G.V.begin(); it != G.V.end(); it++) {
 		Vertex *u = *it;
 		// initially there is no alternating path that ends in the right variant of v
-		u->hk_alternating = false;
+		LP(G, u).hk_alternating = false;
 
 		// reset the bipartite VC
-		u->bp_vc[0] = false;
-		u->bp_vc[1] = false;
+		LP(G, u).bp_vc[0] = false;
+		LP(G, u).bp_vc[1] = false;
 
-		if (Pair_U(u) == &NIL) {
-			Dist(u) = 0;
+		if (Pair_U(G, u) == &NIL) {
+			Dist(G, u) = 0;
 			Q.push(u);
 		} else {
-			Dist(u) = INFTY;
+			Dist(G, u) = INFTY;
 		}
 	}
-	Dist(&NIL) = INFTY;
+	Dist(G, &NIL) = INFTY;
 	
 	while (!Q.empty()) {
 		Vertex *u = Q.front();
 		Q.pop();
 
-		if (Dist(u) < Dist(&NIL)) {
+		if (Dist(G, u) >= Dist(G, &NIL))
+			continue;
+
+		size_t next = Dist(G, u) + 1;
+		if (core_clean(G, u)) {
+			// by id, the neighbours themselves aren't read
+			const CSRGraph &C = G.core;
+			size_t pair = Pair_U(G, u)->id;
+			for (const uint32_t *w = C.begin(u->id); w != C.end(u->id); w++) {
+				if (!C.alive[*w])
+					continue;
+
+				lp_data &d = G.lp[*w + 1];
+				if (*w != pair)
+					d.hk_alternating = true;
+
+				Vertex *p = d.hk_pair[1];
+				if (Dist(G, p) == INFTY) {
+					Dist(G, p) = next;
+					Q.push(p);
+				}
+			}
+		}
+		else {
 			for (auto it = u->edges.begin(); it != u->edges.end(); it++) {
 				Vertex *v = it->first;
-				if (v != Pair_U(u))
-					v->hk_alternating = true;
+				if (v != Pair_U(G, u))
+					LP(G, v).hk_alternating = true;
 
-				if (Dist(Pair_V(v)) == INFTY) {
-					Dist(Pair_V(v)) = Dist(u) + 1;
-					Q.push(Pair_V(v));
+				if (Dist(G, Pair_V(G, v)) == INFTY) {
+					Dist(G, Pair_V(G, v)) = next;
+					Q.push(Pair_V(G, v));
 				}
 			}
 		}
 	}
-	return Dist(&NIL) != INFTY;
+	return Dist(G, &NIL) != INFTY;
 }
 
-bool DFS(Graph &G, Vertex *u) {
-	if (u != &NIL) {
-		for (auto it = u->edges.begin(); it != u->edges.end(); it++) {
-			Vertex *v = it->first;
+/* look for an augmenting path from the free left vertex root along the BFS
+ * layers, and flip the matching along it
+ * each frame is a left vertex and the neighbour slot it's trying
+ */
+bool DFS(Graph &G, Vertex *root) {
+	static thread_local vector< pair<Vertex *, size_t> > stack;
+	stack.clear();
+	stack.emplace_back(root, 0);
+
+	while (!stack.empty()) {
+		Vertex *u = stack.back().first;
+		size_t pos = stack.back().second;
+
+		if (pos == nb_slots(G, u)) {
+			// no path through u
+			Dist(G, u) = INFTY;
+			stack.pop_back();
+			if (!stack.empty())
+				stack.back().second++;
+			continue;
+		}
 
-			if (Dist(Pair_V(v)) == Dist(u) + 1) {
-				if (DFS(G, Pair_V(v)) == true) {
-					Pair_V(v) = u;
-					Pair_U(u) = v;
-					return true;
-				}
-			}
+		Vertex *v = nb_slot(G, u, pos);
+		if (v == nullptr) {
+			stack.back().second++;
+			continue;
+		}
+		Vertex *p = Pair_V(G, v);
+
+		if (Dist(G, p) != Dist(G, u) + 1) {
+			stack.back().second++;
+			continue;
 		}
-		Dist(u) = INFTY;
 
-		return false;	
+		if (p != &NIL) {
+			stack.emplace_back(p, 0);
+			continue;
+		}
+
+		// reached a free right vertex, augment from the end of the path
+		for (auto it = stack.rbegin(); it != stack.rend(); it++) {
+			Vertex *a = it->first;
+			Vertex *b = nb_slot(G, a, it->second);
+			set_pair(G, b, 1, a);
+			set_pair(G, a, 0, b);
+		}
+		return true;
 	}
-	return true;
+
+	return false;
 }
 
+// every vertex starts out unmatched
 void bp_matching_init(Graph &G) {
-	for (auto it = G.V.begin(); it != G.V.end(); it++) {
-		Vertex *a = *it;
-		bp_vertex_create_callback(G, a);
-	}
-
+	G.lp.assign(G.n + 1, lp_data());
 	G.matching = 0;
 }
 
 // hopcroft-karp algorithm
 void bp_matching(Graph &G) {
 	for (Vertex *v: G.V) {
-		if (Pair_U(v) != &NIL) {
-			assert(Pair_V(Pair_U(v)) == v);
+		if (Pair_U(G, v) != &NIL) {
+			assert(Pair_V(G, Pair_U(G, v)) == v);
 		}
 
-		if (Pair_V(v) != &NIL) {
-			assert(Pair_U(Pair_V(v)) == v);
+		if (Pair_V(G, v) != &NIL) {
+			assert(Pair_U(G, Pair_V(G, v)) == v);
 		}
 	}
 
@@ -165,7 +256,7 @@ void bp_matching(Graph &G) {
 		for (auto it = G.V.begin(); it != G.V.end(); it++) {
 			Vertex *u = *it;
 
-			if (Pair_U(u) == &NIL) {
+			if (Pair_U(G, u) == &NIL) {
 				if (DFS(G, u) == true)
 					G.matching++;
 			}
@@ -173,12 +264,12 @@ void bp_matching(Graph &G) {
 	}
 
 	for (Vertex *v: G.V) {
-		if (Pair_U(v) != &NIL) {
-			assert(Pair_V(Pair_U(v)) == v);
+		if (Pair_U(G, v) != &NIL) {
+			assert(Pair_V(G, Pair_U(G, v)) == v);
 		}
 
-		if (Pair_V(v) != &NIL) {
-			assert(Pair_U(Pair_V(v)) == v);
+		if (Pair_V(G, v) != &NIL) {
+			assert(Pair_U(G, Pair_V(G, v)) == v);
 		}
 	}
 }
@@ -189,18 +280,18 @@ void bp_vertex_cover(Graph &G) {
 
 	// check that it's at least a maximal matching
 	for (Vertex *v: G.V) {
-		if (Pair_U(v) == &NIL) {
+		if (Pair_U(G, v) == &NIL) {
 			for (auto pair: v->edges) {
 				Vertex *u = pair.first;
-				assert(Pair_V(u) != &NIL);
+				assert(Pair_V(G, u) != &NIL);
 			}
 		
 		}
 
-		if (Pair_V(v) == &NIL) {
+		if (Pair_V(G, v) == &NIL) {
 			for (auto pair: v->edges) {
 				Vertex *u = pair.first;
-				assert(Pair_U(u) != &NIL);
+				assert(Pair_U(G, u) != &NIL);
 			}
 		}
 	}
@@ -208,164 +299,267 @@ void bp_vertex_cover(Graph &G) {
 
 	for (auto it = G.V.begin(); it != G.V.end(); it++) {
 		Vertex *v = *it;
-		if (v->hk_alternating) {
-			v->bp_vc[1] = true;
+		if (LP(G, v).hk_alternating) {
+			LP(G, v).bp_vc[1] = true;
 		}
 		else {
 			// add the other end of the matched pair
 			// might end up being NIL, but that's ok
-			Pair_V(v)->bp_vc[0] = true;
+			LP(G, Pair_V(G, v)).bp_vc[0] = true;
 		}
 	}
 
 
 	// check that we have a bipartite vertex cover
 	for (Vertex *v: G.V) {
-		if (!v->bp_vc[0]) {
+		if (!LP(G, v).bp_vc[0]) {
 			for (auto pair: v->edges) {
 				Vertex *u = pair.first;
-				assert(u->bp_vc[1]);
+				assert(LP(G, u).bp_vc[1]);
 			}
 		
 		}
 
-		if (!v->bp_vc[1]) {
+		if (!LP(G, v).bp_vc[1]) {
 			for (auto pair: v->edges) {
 				Vertex *u = pair.first;
-				assert(u->bp_vc[0]);
+				assert(LP(G, u).bp_vc[0]);
 			}
 		
 		}
 	}
 }
-
-Vertex s(0, "lp-S-vertex");
-Vertex t(0, "lp-T-vertex");
-
-void visit(Graph &G, Vertex *v, bool left, list< pair<bool, Vertex *> > &L) {
-	int i = left ? 0 : 1;
-	bool next = left ? false : true;
-
-	if (v->lp_visited[i] == true)
-		return;
-	v->lp_visited[i] = true;
-
-	/* left vertices can take any outgoing edge */
-	if (left) {
-		/* iterate over right neighbours */
-		for (auto edge: v->edges) {
-			Vertex *u = edge.first;
-			visit(G, u, false, L);
+// the same as bp_vertex_cover, using Dinic's algorithm on a CSR copy of G
+void bp_vertex_cover_dinic(Graph &G) {
+	static thread_local CSRGraph C;
+	static thread_local vector<uint32_t> match_l;
+	static thread_local vector<uint32_t> match_r;
+	static thread_local vector<uint8_t> reach;
+
+	csr_build(C, G);
+
+	// start from the matching we already have
+	match_l.assign(C.n, FLOW_NONE);
+	match_r.assign(C.n, FLOW_NONE);
+	for (uint32_t i = 0; i < C.n; i++) {
+		Vertex *p = Pair_U(G, C.vertex[i]);
+		if (p != &NIL) {
+			match_l[i] = p->csr_id;
+			match_r[p->csr_id] = i;
 		}
-
-		L.push_front(make_pair(true, v));
 	}
 
-	/* right vertices can only take matched edges */
-	else {
-		if (Pair_V(v) != &NIL) {
-			visit(G, Pair_V(v), true, L);
-		}
+	flow_vertex_cover(C, match_l, match_r, reach);
+
+	// copy the matching back, so it's rolled back with the branch
+	G.matching = 0;
+	for (uint32_t i = 0; i < C.n; i++) {
+		Vertex *v = C.vertex[i];
+		Vertex *p = match_l[i] == FLOW_NONE ? &NIL : C.vertex[match_l[i]];
+		Vertex *q = match_r[i] == FLOW_NONE ? &NIL : C.vertex[match_r[i]];
+
+		if (Pair_U(G, v) != p)
+			set_pair(G, v, 0, p);
+		if (Pair_V(G, v) != q)
+			set_pair(G, v, 1, q);
+		if (p != &NIL)
+			G.matching++;
+
+		LP(G, v).bp_vc[0] = false;
+		LP(G, v).bp_vc[1] = false;
+	}
 
-		L.push_front(make_pair(false, v));
+	for (uint32_t i = 0; i < C.n; i++) {
+		if (reach[i])
+			LP(G, C.vertex[i]).bp_vc[1] = true;
+		else if (match_r[i] != FLOW_NONE)
+			LP(G, C.vertex[match_r[i]]).bp_vc[0] = true;
 	}
 }
 
-// u ist left when left == true
-void assign(Graph &G, Vertex *v, Vertex *root, bool left, bool root_left) {
-	int i = left ? 0 : 1;
-	int j = root_left ? 0 : 1;
-	bool next = left ? false : true;
 
-	if (v->lp_root[i].second != nullptr)
+#define SCC_NONE    numeric_limits<uint32_t>::max()
+#define SCC_PENDING (numeric_limits<uint32_t>::max() - 1)
+
+/* strongly connected components of the residual graph of the double cover
+ * node 2 * i is the left and 2 * i + 1 the right copy of verts[i]. A left
+ * node has an edge to the right copy of every neighbour, a right node one to
+ * the left copy of its matched partner
+ */
+struct lp_scc {
+	vector<Vertex *> verts;
+
+	// scc of each node, SCC_NONE once its vertex left the graph and
+	// SCC_PENDING while tarjan hasn't reached it yet
+	vector<uint32_t> comp;
+	// the nodes of scc c are nodes[begin[c]] ... nodes[end[c] - 1]
+	// an scc that has been split up again is empty
+	vector<uint32_t> nodes;
+	vector<uint32_t> begin;
+	vector<uint32_t> end;
+
+	// sccs that have to be checked by lp_scc_check
+	vector<uint32_t> work;
+	vector<uint8_t> queued;
+
+	/* tarjan */
+	vector<uint32_t> index;
+	vector<uint32_t> low;
+	vector<uint8_t> on_stack;
+	vector<uint32_t> stack;
+	// node and the position of the next edge to follow
+	vector< pair<uint32_t, size_t> > calls;
+	uint32_t counter;
+};
+
+static inline Vertex *lp_scc_vertex(lp_scc &S, uint32_t a) {
+	return S.verts[a >> 1];
+}
+
+static void lp_scc_queue(lp_scc &S, uint32_t c) {
+	if (c >= SCC_PENDING || S.queued[c])
 		return;
+	S.queued[c] = true;
+	S.work.push_back(c);
+}
 
-	v->lp_root[i].second = root;
-	v->lp_root[i].first = root_left;
-	root->scc[j].push_back(make_pair(left, v));
+// the target of the pos-th edge of node a, or SCC_NONE if there is none
+static inline uint32_t lp_scc_edge(Graph &G, lp_scc &S, uint32_t a, size_t pos) {
+	Vertex *v = lp_scc_vertex(S, a);
 
-	if (left) {
-		if (Pair_U(v) != &NIL) {
-			assign(G, Pair_U(v), root, false, root_left);
-		}
+	if ((a & 1) == 0) {
+		if (pos < v->edges.size())
+			return 2 * v->edges[pos].first->csr_id + 1;
 	}
-	else {
-		/* iterate over left neighbours */
-		for (auto edge: v->edges) {
-			Vertex *u = edge.first;
-			assign(G, u, root, true, root_left);
-		}
+	else if (pos == 0 && Pair_V(G, v) != &NIL) {
+		return 2 * Pair_V(G, v)->csr_id;
 	}
-}
-
-bool check_scc(Graph &G, Vertex *root, bool left, long long &lower_bound) {
-	int i = left ? 0 : 1;
-	auto &SCC = root->scc[i];
-	bool useable = true;
-
-	assert(SCC.size() > 0);
-	if (SCC.size() == 1)
-		return false;
 
-	for (auto pair: SCC) {
-		Vertex *v = pair.second;
-		bool left2 = pair.first;
+	return SCC_NONE;
+}
 
-		if (v == &s || v == &t)
+/* iterative tarjan on the nodes with comp == SCC_PENDING, starting at root
+ * every scc found is queued for checking
+ */
+static void lp_scc_tarjan(Graph &G, lp_scc &S, uint32_t root) {
+	S.index[root] = S.low[root] = S.counter++;
+	S.stack.push_back(root);
+	S.on_stack[root] = true;
+	S.calls.emplace_back(root, 0);
+
+	while (!S.calls.empty()) {
+		uint32_t a = S.calls.back().first;
+		size_t pos = S.calls.back().second++;
+		uint32_t b = lp_scc_edge(G, S, a, pos);
+
+		if (b != SCC_NONE) {
+			if (S.comp[b] != SCC_PENDING)
+				continue;
+
+			if (S.index[b] == SCC_NONE) {
+				S.index[b] = S.low[b] = S.counter++;
+				S.stack.push_back(b);
+				S.on_stack[b] = true;
+				S.calls.emplace_back(b, 0);
+			}
+			else if (S.on_stack[b]) {
+				S.low[a] = min(S.low[a], S.index[b]);
+			}
 			continue;
-		if (v->deg == 0) {
-			/* v already is in the vertex cover */
-			useable = false;
-			break;
 		}
 
-		if (v->lp_root[0].second == v->lp_root[1].second && v->lp_root[0].first == v->lp_root[1].first) {
-			useable = false;
-			break;
+		// all edges of a are done
+		S.calls.pop_back();
+		if (!S.calls.empty()) {
+			uint32_t p = S.calls.back().first;
+			S.low[p] = min(S.low[p], S.low[a]);
 		}
 
-		// go over all outgoing edges
-		if (left2) {
-			for (auto edge: v->edges) {
-				Vertex *u = edge.first;
-				// check if u is in this SCC
-				if (u->lp_root[1].second != root || u->lp_root[1].first != left) {
-					useable = false;
-					break;
-				}
-			}
-		}
-		else {
-			if (Pair_V(v) != &NIL) {
-				Vertex *p = Pair_V(v);
-				// check if p is in this SCC
-				if (p->lp_root[0].second != root || p->lp_root[0].first != left) {
-					useable = false;
-					break;
-				}
-
-			}
-		}
+		if (S.low[a] != S.index[a])
+			continue;
 
-		if (!useable)
-			break;
+		// a is the root of an scc
+		uint32_t c = S.begin.size();
+		S.begin.push_back(S.nodes.size());
+		uint32_t w;
+		do {
+			w = S.stack.back();
+			S.stack.pop_back();
+			S.on_stack[w] = false;
+			S.comp[w] = c;
+			S.nodes.push_back(w);
+		} while (w != a);
+		S.end.push_back(S.nodes.size());
+
+		S.queued.push_back(false);
+		lp_scc_queue(S, c);
 	}
+}
 
-
-	if (!useable) {
+/* an scc can be taken if it has no outgoing edges and doesn't contain both
+ * copies of a vertex. Its left vertices are then not in the vertex cover and
+ * its right vertices are
+ */
+static bool lp_scc_check(Graph &G, lp_scc &S, uint32_t c) {
+	if (S.end[c] - S.begin[c] <= 1)
 		return false;
+
+	for (uint32_t i = S.begin[c]; i < S.end[c]; i++) {
+		uint32_t a = S.nodes[i];
+
+		if (S.comp[a ^ 1] == c)
+			return false;
+
+		for (size_t pos = 0; ; pos++) {
+			uint32_t b = lp_scc_edge(G, S, a, pos);
+			if (b == SCC_NONE)
+				break;
+			if (S.comp[b] != c)
+				return false;
+		}
 	}
 
+	return true;
+}
 
-	// apply optimization
-	for (auto pair: SCC) {
-		Vertex *v = pair.second;
-		bool left2 = pair.first;
+// the vertex of node a left the graph, the scc it was in has to be split up
+static void lp_scc_remove(lp_scc &S, uint32_t a, vector<uint32_t> &split) {
+	uint32_t c = S.comp[a];
+	if (c == SCC_NONE)
+		return;
 
-		if (v == &s || v == &t)
-			continue;
+	S.comp[a] = SCC_NONE;
+	split.push_back(c);
+}
+
+// take scc c and update the sccs around it
+static void lp_scc_apply(Graph &G, lp_scc &S, uint32_t c, long long &lower_bound) {
+	static thread_local vector<Vertex *> removed;
+	static thread_local vector<Vertex *> pred;
+	static thread_local vector<uint32_t> split;
+	static thread_local vector<uint32_t> pending;
+
+	removed.clear();
+	pred.clear();
+	split.clear();
+	pending.clear();
+
+	// remember who has an edge into the vertices we remove: the left copies
+	// of their neighbours and the right copies of their partners
+	for (uint32_t i = S.begin[c]; i < S.end[c]; i++) {
+		Vertex *v = lp_scc_vertex(S, S.nodes[i]);
+		removed.push_back(v);
+		for (auto edge: v->edges)
+			pred.push_back(edge.first);
+		if (Pair_U(G, v) != &NIL)
+			pred.push_back(Pair_U(G, v));
+	}
+
+	for (uint32_t i = S.begin[c]; i < S.end[c]; i++) {
+		uint32_t a = S.nodes[i];
+		Vertex *v = lp_scc_vertex(S, a);
 
-		if (left2) {
+		if ((a & 1) == 0) {
 			delete_vertex(G, v);
 		}
 		else {
@@ -374,88 +568,110 @@ bool check_scc(Graph &G, Vertex *root, bool left, long long &lower_bound) {
 		}
 	}
 
+	// neighbours without edges left the graph as well
+	for (Vertex *u: pred) {
+		if (u->deg == 0)
+			removed.push_back(u);
+	}
 
-	return true;
-}
-
-/* kosaraju's algorithm - wikipedia */
-void lp_flow_optimize(Graph &G, long long &lower_bound) {
-	// is left vertex? + Vertex *
-	list< pair<bool, Vertex *> > L;
-
-	size_t n_iter = 3;
-start:
-	/* step 1 */
-	for (Vertex *v: G.V) {
-		v->lp_visited[0] = false;
-		v->lp_visited[1] = false;
-		v->lp_root[0].second = nullptr;
-		v->lp_root[1].second = nullptr;
-		v->lp_root[0].first = false;
-		v->lp_root[1].first = false;
-		v->lp_marked[0] = false;
-		v->lp_marked[1] = false;
-		v->scc[0].clear();
-		v->scc[1].clear();
-		v->marked = false;
+	for (Vertex *v: removed) {
+		lp_scc_remove(S, 2 * v->csr_id, split);
+		lp_scc_remove(S, 2 * v->csr_id + 1, split);
 	}
 
-	/* step 2 */
-	for (Vertex *v: G.V) {
-		visit(G, v, false, L);
-		visit(G, v, true, L);
+	// removing nodes can only split sccs, so tarjan only has to look at the
+	// remaining nodes of the ones that lost some
+	for (uint32_t d: split) {
+		for (uint32_t i = S.begin[d]; i < S.end[d]; i++) {
+			uint32_t a = S.nodes[i];
+			if (S.comp[a] != d)
+				continue;
+
+			S.comp[a] = SCC_PENDING;
+			S.index[a] = SCC_NONE;
+			pending.push_back(a);
+		}
+		S.end[d] = S.begin[d];
 	}
 
-	/* step 3 */
-	for (auto pair: L) {
-		bool left = pair.first;
-		Vertex *v = pair.second;
+	for (uint32_t a: pending) {
+		if (S.index[a] == SCC_NONE)
+			lp_scc_tarjan(G, S, a);
+	}
 
-		assign(G, v, v, left, left);
+	// sccs that had edges into the removed vertices may have none left now
+	for (Vertex *u: pred) {
+		if (u->deg == 0)
+			continue;
+		lp_scc_queue(S, S.comp[2 * u->csr_id]);
+		lp_scc_queue(S, S.comp[2 * u->csr_id + 1]);
 	}
+}
 
-	/* step 4 - VL */
+/* take the sccs of the residual graph that no edge leaves until there are
+ * none left, only the sccs changed by taking one are looked at again
+ */
+void lp_flow_optimize(Graph &G, long long &lower_bound) {
+	static thread_local lp_scc S;
+
+	S.verts.assign(G.V.begin(), G.V.end());
+	for (size_t i = 0; i < S.verts.size(); i++)
+		S.verts[i]->csr_id = i;
+
+	uint32_t n = 2 * S.verts.size();
+	S.comp.assign(n, SCC_PENDING);
+	S.index.assign(n, SCC_NONE);
+	S.low.resize(n);
+	S.on_stack.assign(n, false);
+	S.nodes.clear();
+	S.begin.clear();
+	S.end.clear();
+	S.work.clear();
+	S.queued.clear();
+	S.counter = 0;
+
+	for (uint32_t a = 0; a < n; a++) {
+		if (S.index[a] == SCC_NONE)
+			lp_scc_tarjan(G, S, a);
+	}
 
-	bool ran = false;
+	while (!S.work.empty()) {
+		uint32_t c = S.work.back();
+		S.work.pop_back();
+		S.queued[c] = false;
 
-	list<Vertex *> listV(G.V);
-	for (Vertex *v: listV) {
-		if (v->lp_root[0].second == v && v->lp_root[0].first == true) {
-			ran = ran || check_scc(G, v, true, lower_bound);
-		}
-	//	if (ran)
-	//		break;
-		if (v->lp_root[1].second == v && v->lp_root[1].first == false) {
-			ran = ran || check_scc(G, v, false, lower_bound);
-		}
-	//	if (ran)
-	//		break;
-	}
-	if (ran) {
-		L.clear();
-		goto start;
+		if (lp_scc_check(G, S, c))
+			lp_scc_apply(G, S, c, lower_bound);
 	}
 }
 
 
 long long lp_bound(Graph &G) {
+	stat_scope scope(G, STAT_LP_BOUND);
 	long long ones = 0;
 	long long halves = 0;
 
 	if (!lp_bound_check_feasability(G))
 		return 0ll;
 
-	bp_vertex_cover(G);
+	// the per vertex data is allocated the first time it's needed
+	if (G.lp.empty())
+		bp_matching_init(G);
+
+	if (LP_ENGINE == LP_ENGINE_DINIC)
+		bp_vertex_cover_dinic(G);
+	else
+		bp_vertex_cover(G);
 
-	list<Vertex *> listV(G.V);
+	vector<Vertex *> listV(G.V.begin(), G.V.end());
 #if 1
 	for (Vertex *v: listV) {
 
-		if (!v->bp_vc[0] && !v->bp_vc[1]) {
+		if (!LP(G, v).bp_vc[0] && !LP(G, v).bp_vc[1]) {
 			delete_vertex(G, v);
 			; //nothing
 		}
-		else if (v->bp_vc[0] && v->bp_vc[1]) {
+		else if (LP(G, v).bp_vc[0] && LP(G, v).bp_vc[1]) {
 			add_to_vc(G, v);
 			//ones++;
 		}
@@ -5,12 +5,14 @@
 void bp_matching_init(Graph &G);
 void bp_matching(Graph &G);
 void bp_vertex_cover(Graph &G);
+void bp_vertex_cover_dinic(Graph &G);
 
 long long lp_bound(Graph &G);
 
 void bp_vertex_delete_callback(Graph &G, Vertex *v);
 void bp_vertex_create_callback(Graph &G, Vertex *v);
 void bp_edge_delete_callback(Graph &G, Edge *e);
+void bp_restore_pair(Graph &G, Vertex *v, int side, Vertex *p);
 
 void tarjan(Vertex* v, list<Vertex *>* S, size_t maxdfs, bool left);
 void strongly_connected_components(Graph &G);
@@ -18,3 +20,10 @@ void lp_flow(Graph &G);
 
 /* configurables */
 extern size_t LP_BOUND_CUTOFF;
+
+// how lp_bound solves the LP relaxation
+enum lp_engine {
+	LP_ENGINE_HK,     // Hopcroft-Karp on the Vertex objects
+	LP_ENGINE_DINIC,  // Dinic on a CSR copy of the graph
+};
+extern lp_engine LP_ENGINE;
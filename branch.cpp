@@ -2,6 +2,9 @@
 #include <cassert>
 #include <algorithm>
 #include <string>
+#include <atomic>
+#include <numeric>
+#include <limits>
 
 #include "graph.h"
 #include "branch.h"
@@ -14,6 +17,9 @@
 #include "stats.h"
 #include "constraints.h"
 #include "score.h"
+#include "parallel.h"
+#include "heuristic.h"
+#include "time.h"
 
 
 bool CONFIG_MIRROR           = true;
@@ -22,10 +28,35 @@ bool CONFIG_BRANCHING_V2     = true;
 bool CONFIG_LP_BOUND         = true;
 bool CONFIG_CLIQUE_BOUND     = true;
 
-void vc_branch_v2(Graph &G, list<Vertex *> &best, long long size, long long &u);
+size_t CONFIG_THREADS        = 1;
+size_t PARALLEL_CUTOFF       = 50;
+
+long long vc_branch_v2(Graph &G, list<Vertex *> &best, long long size, long long &u);
+
+// size of the best cover of the whole graph found by any thread
+static atomic<long long> incumbent;
+
+// the best cover of G we still care about is smaller than this
+static long long vc_upper_bound(Graph &G, long long u) {
+	u = min(u, incumbent.load(memory_order_relaxed) - G.offset);
+	if (G.limit != nullptr)
+		u = min(u, G.limit->load(memory_order_relaxed) - G.offset);
+	return u;
+}
+
+// let the other threads prune with a cover of size size
+static void publish_sol(Graph &G, long long size) {
+	if (G.split_depth > 0)
+		return;
+
+	long long total = G.offset + size;
+	long long cur = incumbent.load(memory_order_relaxed);
+	while (total < cur && !incumbent.compare_exchange_weak(cur, total))
+		;
+}
 
 void write_best_sol(Graph &G, list<Vertex *> &best, long long size, long long &u) {
-	if (size < u) {
+	if (size < vc_upper_bound(G, u)) {
 		u = size;
 		best.clear();
 		read_vc(G, best);
@@ -33,41 +64,118 @@ void write_best_sol(Graph &G, list<Vertex *> &best, long long size, long long &u
 		for (Vertex *a: best)
 			a->in_vc = false;
 		assert(best.size() == u);
+
+		publish_sol(G, size);
 	}
 }
 
+// put every vertex reachable from v into the component counter
 void component_dfs(Vertex* v, size_t counter) {
+	// vertices and the position of the next edge to look at
+	static thread_local vector< pair<Vertex *, size_t> > stack;
+
 	v->component = counter;
-	for (auto edge : v->edges) {
-		Vertex* neighbour = edge.first;
+	stack.clear();
+	stack.emplace_back(v, 0);
+
+	while (!stack.empty()) {
+		Vertex *a = stack.back().first;
+		size_t &pos = stack.back().second;
+
+		if (pos == a->edges.size()) {
+			stack.pop_back();
+			continue;
+		}
+
+		Vertex* neighbour = a->edges[pos++].first;
 		if(neighbour->component == 0) {
-			component_dfs(neighbour, counter);
+			neighbour->component = counter;
+			stack.emplace_back(neighbour, 0);
 		}
 	}
 }
 
+static void vc_run_component(vc_task *t) {
+	vc_branch_v2(t->G, t->best, 0, t->u);
+
+	// leave less room for the other components, or none if this one
+	// didn't fit
+	if (t->best.empty())
+		t->G.limit->store(0);
+	else
+		t->G.limit->fetch_sub(t->best.size());
+}
+
+/* solve the components on copies in other threads, the largest first
+ * their covers are added to all_comp_sol and their sizes to size
+ * returns false if the covers don't fit into u together
+ */
+static bool vc_split_parallel(Graph &G, vector< vector<Vertex *> > &components, size_t n_comp, long long &size, long long u, list<Vertex *> &all_comp_sol) {
+	vector<size_t> order(n_comp);
+	iota(order.begin(), order.end(), 1);
+	stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+		return components[a].size() > components[b].size();
+	});
+
+	// the components share the room left by the ones already solved
+	atomic<long long> limit(G.offset + vc_upper_bound(G, u));
+
+	// the first ones are stolen first, we'll do the small ones ourselves
+	vector<vc_task *> tasks;
+	for (size_t i: order) {
+		vc_task *t = new vc_task();
+
+		G.V.assign(components[i].begin(), components[i].end());
+		graph_copy(t->G, G, t->origin);
+		G.V.clear();
+
+		t->G.offset      = G.offset + size;
+		t->G.split_depth = G.split_depth + 1;
+		t->G.limit       = &limit;
+		t->G.depth       = G.depth + 1;
+
+		t->run = vc_run_component;
+		t->u   = u - size;
+
+		pool_spawn(t);
+		tasks.push_back(t);
+	}
+
+	for (auto it = tasks.rbegin(); it != tasks.rend(); it++) {
+		pool_join(*it);
+	}
+
+	bool found = true;
+	for (vc_task *t: tasks) {
+		G.recursive_steps += t->G.recursive_steps;
+		G.trail_undone    += t->G.trail_undone;
+
+		if (t->best.empty())
+			found = false;
+
+		size += t->best.size();
+		for (Vertex *a: t->best)
+			all_comp_sol.push_back(t->origin[a->id]);
+
+		delete t;
+	}
+
+	return found && size < u;
+}
+
 void vc_branch_split(Graph &G, size_t n_comp, list<Vertex *> &best, long long size, long long &u) {
 	// every node is part of a component
 	for(auto node : G.V) {
 		assert(node->component != 0);
 	}
 
-	size_t old_v_size = G.V.size();
 
-
-	list<Vertex *> old_V;;
-	list<Vertex *> old_deg1s;
-	list<Vertex *> old_deg2s;
-	list<Vertex *> old_deg3s;
-	vector<GraphModification *> old_changes;
+	vector<trail_entry> old_trail;
 	vector<Vertex *> old_VC;
+	vector<Vertex *> old_dirty[NUM_DIRTY];
+	vector< vector<Vertex *> > comp_dirty[NUM_DIRTY];
 
-	old_V.splice(old_V.end(), G.V);
-	old_deg1s.splice(old_deg1s.end(), G.deg1s);
-	old_deg2s.splice(old_deg2s.end(), G.deg2s);
-	old_deg3s.splice(old_deg3s.end(), G.deg3s);
-
-	old_changes.swap(G.changes);
+	old_trail.swap(G.trail);
 	old_VC.swap(G.VC.V);
 
 
@@ -75,46 +183,54 @@ void vc_branch_split(Graph &G, size_t n_comp, list<Vertex *> &best, long long si
 	bool found = true;
 
 
-	list<Vertex *> components[n_comp+1];
-	for (auto it = old_V.begin(); it != old_V.end(); ) {
-		Vertex *node = *it;
-		auto next = it;
-		next++;
-
+	vector< vector<Vertex *> > components(n_comp + 1);
+	for (Vertex *node: G.V) {
 		assert(node->component >= 1 && node->component <= n_comp);
 		assert(!node->in_vc);
 
-		size_t i = node->component;
-		components[i].splice(components[i].end(), old_V, it);
-		it = next;
+		components[node->component].push_back(node);
 	}
+	G.V.clear();
 
+	if (pool_has_idle()) {
+		found = vc_split_parallel(G, components, n_comp, size, u, all_comp_sol);
+		goto done;
+	}
 
+	// the rules only get the vertices of the component they work on. Sort
+	// them now, splits inside a component renumber its vertices
+	for (int r = 0; r < NUM_DIRTY; r++) {
+		old_dirty[r].swap(G.dirty[r]);
+		comp_dirty[r].resize(n_comp + 1);
+		for (Vertex *a: old_dirty[r]) {
+			if (a->deg > 0)
+				comp_dirty[r][a->component].push_back(a);
+		}
+	}
 
 	for (size_t i = 1; i <= n_comp; i++) {
-		G.V.splice(G.V.end(), components[i]);
+		G.V.assign(components[i].begin(), components[i].end());
+		graph_init_lists(G);
 
-		for (Vertex *node: G.V) {
-			if (node->deg == 1) {
-				G.deg1s.splice(G.deg1s.end(), old_deg1s, node->iter1);
-			}
-			if (node->deg == 2) {
-				G.deg2s.splice(G.deg2s.end(), old_deg2s, node->iter2);
-			}
-			if (node->deg == 3) {
-				G.deg3s.splice(G.deg3s.end(), old_deg3s, node->iter3);
-			}
-		}
+		for (int r = 0; r < NUM_DIRTY; r++)
+			G.dirty[r].swap(comp_dirty[r][i]);
 
 		assert(G.V.size() != 0);
 		assert(G.VC.V.size() == 0);
-		assert(G.changes.size() == 0);
+		assert(G.trail.size() == 0);
 
 
 		list<Vertex*> comp_sol;
 		long long u_comp = u - size;
 
+		// the other components need at least 0 vertices
+		G.offset += size;
+		G.split_depth++;
+		G.depth++;
 		vc_branch_v2(G, comp_sol, 0, u_comp);
+		G.depth--;
+		G.split_depth--;
+		G.offset -= size;
 
 		if (comp_sol.size() == 0) {
 			// could not find better solution
@@ -127,31 +243,32 @@ void vc_branch_split(Graph &G, size_t n_comp, list<Vertex *> &best, long long si
 
 	fail:
 
-		components[i].splice(components[i].end(), G.V);
-		old_deg1s.splice(old_deg1s.end(), G.deg1s);
-		old_deg2s.splice(old_deg2s.end(), G.deg2s);
-		old_deg3s.splice(old_deg3s.end(), G.deg3s);
+		// the search restored the component, components[i] still has it
+		G.V.clear();
 
 		if (!found)
 			break;
 	}
 
+	for (int r = 0; r < NUM_DIRTY; r++)
+		G.dirty[r].swap(old_dirty[r]);
+
+done:
 
 
 	assert(G.V.size() == 0);
 	assert(G.VC.V.size() == 0);
-	assert(G.changes.size() == 0);
+	assert(G.trail.size() == 0);
 
 
 	// cleanup
 
 	for (size_t i = 1; i <= n_comp; i++) {
-		G.V.splice(G.V.end(), components[i]);
+		for (Vertex *node: components[i])
+			G.V.push_back(node);
 	}
-	G.deg1s.splice(G.deg1s.end(), old_deg1s);
-	G.deg2s.splice(G.deg2s.end(), old_deg2s);
-	G.deg3s.splice(G.deg3s.end(), old_deg3s);
-	G.changes.swap(old_changes);
+	graph_init_lists(G);
+	G.trail.swap(old_trail);
 	G.VC.V.swap(old_VC);
 
 	if (found) {
@@ -170,6 +287,7 @@ void vc_branch_split(Graph &G, size_t n_comp, list<Vertex *> &best, long long si
 			a->in_vc = false;
 
 		assert(u == best.size());
+		publish_sol(G, u);
 	}
 
 
@@ -177,12 +295,120 @@ void vc_branch_split(Graph &G, size_t n_comp, list<Vertex *> &best, long long si
 
 }
 
-void vc_branch_v2(Graph &G, list<Vertex *> &best, long long size, long long &u) {
+// branch on v, choice 0 adds v to the cover and choice 1 its neighbours
+// returns the lower bound the search proved for this branch
+static long long vc_branch_child(Graph &G, Vertex *v, int choice, list<Vertex *> &best, long long size, long long &u) {
+	/* information for rollback */
+	struct graph_snapshot snapshot;
+	snapshot = create_snapshot(G);
+	size_t old_vc_size = G.VC.V.size();
+	size_t old_vce_size = G.VC.E.size();
+	size_t old_e_size = G.E.size();
+
+	long long k = 0;
+
+	/* add v or N(v) to the vertex cover */
+	if (choice == 0) {
+		//G.constraints.push_back(new NotAllNeighboursConstraint(v));
+
+		if (CONFIG_MIRROR) {
+			add_mirrors_to_vc(G, v);
+		}
+		add_to_vc(G, v);
+	} else {
+		// iterate over the neighbours
+		while (v->edges.size() > 0) {
+			Vertex *u = v->edges[0].first;
+
+			// add the neighbour u
+			add_to_vc(G, u);
+		}
+	}
+
+	/* optimize */
+	vc_optimize(G, k);	// can decrement k
+
+	/* branch */
+	size_t vc_diff = G.VC.V.size() - old_vc_size - k; // k <= 0
+	G.depth++;
+	long long bound = vc_branch_v2(G, best, size + vc_diff, u);
+	G.depth--;
+
+	/* rollback */
+	restore_snapshot(G, snapshot);
+	assert(G.VC.V.size() == old_vc_size);
+	assert(G.VC.E.size() == old_vce_size);
+	assert(G.E.size()    == old_e_size);
+
+	return bound;
+}
+
+static void vc_run_branch(vc_task *t) {
+	t->bound = vc_branch_child(t->G, t->v, t->choice, t->best, 0, t->u);
+}
+
+// solve the branch adding v to the cover on a copy of G in another thread
+static vc_task *vc_spawn_branch(Graph &G, Vertex *v, long long size, long long u) {
+	vc_task *t = new vc_task();
+
+	vector<Vertex *> copy = graph_copy(t->G, G, t->origin);
+	t->G.offset      = G.offset + size;
+	t->G.split_depth = G.split_depth;
+	t->G.limit       = G.limit;
+	t->G.depth       = G.depth;
+
+	t->run    = vc_run_branch;
+	t->v      = copy[v->pos_V];
+	t->choice = 0;
+	t->u      = vc_upper_bound(G, u) - size;
+
+	pool_spawn(t);
+	return t;
+}
+
+// wait for t and translate its cover back into a cover of the original graph
+// returns the lower bound t proved for its branch
+static long long vc_join_branch(Graph &G, vc_task *t, list<Vertex *> &best, long long size, long long &u) {
+	pool_join(t);
+
+	long long bound = size + t->bound;
+
+	G.recursive_steps += t->G.recursive_steps;
+	G.trail_undone    += t->G.trail_undone;
+
+	if (!t->best.empty() && size + (long long) t->best.size() < u) {
+		u = size + t->best.size();
+		best.clear();
+		for (Vertex *a: t->best) {
+			assert(a->id < t->origin.size());
+			rvc_add_vertex(t->origin[a->id], best);
+		}
+
+		read_vc(G, best);
+		for (Vertex *a: best)
+			a->in_vc = false;
+
+		assert(u == best.size());
+	}
+
+	delete t;
+	return bound;
+}
+
+/* search for a cover of G smaller than u, size vertices are already taken
+ * returns a lower bound for the covers in this subtree, like vc_branch
+ */
+long long vc_branch_v2(Graph &G, list<Vertex *> &best, long long size, long long &u) {
 	if (G.V.empty()) {
+		stats_node(G.depth, NODE_SOLVED);
 		write_best_sol(G, best, size, u);
-		return;
+		return size;
 	}
 
+	// out of time, vertex_cover_v2 prints the best cover so far
+	if (time_expired(G.recursive_steps))
+		return size;
+
 	G.recursive_steps++;
 
 	/* information for rollback */
@@ -192,28 +418,39 @@ void vc_branch_v2(Graph &G, list<Vertex *> &best, long long size, long long &u)
 
 	/* compute lower bound */
 	long long lower_bound = 1;	// since we have at least one edge
+	long long lp = 0;
+	long long clique = 0;
 	size_t tmp_vc = G.VC.V.size();
 
-	if (CONFIG_LP_BOUND)
-		lower_bound = max(lower_bound, lp_bound(G)); // modifies the graph
+	if (CONFIG_LP_BOUND) {
+		lp = lp_bound(G); // modifies the graph
+		lower_bound = max(lower_bound, lp);
+	}
 
 	size += G.VC.V.size() - tmp_vc;
 	Vertex *v = nullptr;
-	Vertex *max_deg = nullptr;
 	size_t counter = 0;
 	long long fake_k = 0;
 	size_t m = 0;
+	vc_task *task = nullptr;
+	long long result = size;
+	long long old_u = u;
 
 	if (G.V.empty()) {
+		stats_node(G.depth, NODE_SOLVED);
 		write_best_sol(G, best, size, u);
 		goto end;
 	}
 
-	if (CONFIG_CLIQUE_BOUND)
-		lower_bound = max(lower_bound, clique_bound(G));
+	if (CONFIG_CLIQUE_BOUND) {
+		clique = clique_bound(G);
+		lower_bound = max(lower_bound, clique);
+	}
 
 	// stop branching if we can't hope to improve the solution
-	if (size + lower_bound >= u) {
+	if (size + lower_bound >= vc_upper_bound(G, u)) {
+		long long limit = vc_upper_bound(G, u);
+		stats_node(G.depth, size + lp >= limit ? NODE_LP : size + clique >= limit ? NODE_CLIQUE : NODE_INCUMBENT);
 		goto fail;
 	}
 
@@ -226,14 +463,19 @@ void vc_branch_v2(Graph &G, list<Vertex *> &best, long long size, long long &u)
 
 	if (CONFIG_COMPONENTS) {
 		// compute connected components
-		for(auto node : G.V) {
-			node->component = 0;
-		}
-		for(auto node : G.V) {
-			if(node->component == 0) {
-				counter++;
-				component_dfs(node, counter);
+		{
+			stat_scope scope(G, STAT_SPLIT);
+			for(auto node : G.V) {
+				node->component = 0;
+			}
+			for(auto node : G.V) {
+				if(node->component == 0) {
+					counter++;
+					component_dfs(node, counter);
+				}
 			}
+			if (counter >= 2)
+				scope.applied();
 		}
 		
 
@@ -241,7 +483,11 @@ void vc_branch_v2(Graph &G, list<Vertex *> &best, long long size, long long &u)
 		assert(counter >= 1);
 
 		if(counter >= 2) {
+			stats_node(G.depth, NODE_SPLIT);
 			vc_branch_split(G, counter, best, size, u);
+
+			// the cover of the components, or none fits below the limit
+			result = u < old_u ? u : max(size + lower_bound, vc_upper_bound(G, u));
 			goto end;
 		}
 	}
@@ -249,73 +495,72 @@ void vc_branch_v2(Graph &G, list<Vertex *> &best, long long size, long long &u)
 	/* select vertex with the highest degree */
 	//graph_assign_scores(G);
 
-	v = G.V.front();
-	
-	for (Vertex *a: G.V) {
-		m += a->deg;
-
-		if (a->deg > v->deg)
-			v = a;
-	}
-
-	m /= 2;
+	v = G.buckets.max();
+	m = G.buckets.deg_sum / 2;
 
 	// apply k^2 bound
-	fake_k = u - size;
+	fake_k = vc_upper_bound(G, u) - size;
 	if (v->deg <= fake_k) {
 		if (G.V.size() > fake_k * fake_k + fake_k || m > fake_k * fake_k) {
+			stats_node(G.depth, NODE_K2);
 			goto fail;
 		}
 	}
 
-	for (int i = 0; i < 2; i++) {
-		/* information for rollback */
-		struct graph_snapshot snapshot;
-		snapshot = create_snapshot(G);
-		size_t old_vc_size = G.VC.V.size();
-		size_t old_vce_size = G.VC.E.size();
-		size_t old_e_size = G.E.size();
-
-		long long k = 0;
+	stats_node(G.depth, NODE_BRANCHED);
 
-		/* add v or N(v) to the vertex cover */
-		if (i == 0) {
-			//G.constraints.push_back(new NotAllNeighboursConstraint(v));
+	// let an idle thread take v while we take N(v)
+	if (pool_has_idle() && G.V.size() >= PARALLEL_CUTOFF)
+		task = vc_spawn_branch(G, v, size, u);
 
-			if (CONFIG_MIRROR) {
-				add_mirrors_to_vc(G, v);
-			}
-			add_to_vc(G, v);
-		} else {
-			// iterate over the neighbours
-			while (v->edges.size() > 0) {
-				Vertex *u = v->edges[0].first;
-
-				// add the neighbour u
-				add_to_vc(G, u);
-			}
-		}
+	result = numeric_limits<long long>::max();
+	for (int i = task != nullptr ? 1 : 0; i < 2; i++) {
+		result = min(result, vc_branch_child(G, v, i, best, size, u));
+	}	
 
-		/* optimize */
-		vc_optimize(G, k);	// can decrement k
+	if (task != nullptr)
+		result = min(result, vc_join_branch(G, task, best, size, u));
 
-		/* branch */
-		size_t vc_diff = G.VC.V.size() - old_vc_size - k; // k <= 0
-		vc_branch_v2(G, best, size + vc_diff, u);
+	// use the result of the branching to improve the lower bound
+	result = max(result, size + lower_bound);
+	if (!TIME_stop)
+		stats_gap(G.depth, result - (size + lower_bound));
+	goto end;
 
-		/* rollback */
-		restore_snapshot(G, snapshot);
-		assert(G.VC.V.size() == old_vc_size);
-		assert(G.VC.E.size() == old_vce_size);
-		assert(G.E.size()    == old_e_size);
-	}	
+fail:
+	// the bounds showed there is no cover below the limit in here
+	result = max(size + lower_bound, vc_upper_bound(G, u));
 
 end:
-fail:
 	/* undo changes by lp_bound */
 	restore_snapshot(G, pre_snapshot);
 
-	return;
+	return result;
+}
+
+// the lower bound of the root of vc_branch_v2, for the cover of G.V only
+static long long vc_kernel_lower_bound(Graph &G) {
+	struct graph_snapshot snapshot;
+	snapshot = create_snapshot(G);
+
+	long long lower_bound = 0;
+	size_t tmp_vc = G.VC.V.size();
+
+	if (!G.V.empty() && CONFIG_LP_BOUND)
+		lower_bound = lp_bound(G); // modifies the graph
+
+	long long added = G.VC.V.size() - tmp_vc;
+	if (!G.V.empty()) {
+		lower_bound = max(lower_bound, 1ll);
+		if (CONFIG_CLIQUE_BOUND)
+			lower_bound = max(lower_bound, clique_bound(G));
+	}
+	else {
+		lower_bound = 0;
+	}
+
+	restore_snapshot(G, snapshot);
+	return added + lower_bound;
 }
 
 void vertex_cover_v2(Graph &G, string td, size_t n) {
@@ -324,8 +569,6 @@ void vertex_cover_v2(Graph &G, string td, size_t n) {
 	long long u = G.n;
 
 
-	/* init */
-	bp_matching_init(G);
 
 	/* optimize graph */
 	vc_preoptimize(G, k);
@@ -333,16 +576,37 @@ void vertex_cover_v2(Graph &G, string td, size_t n) {
 
 	print_graph_optimization(G);
 
+	// the search starts from the kernel, the rules left few rows of the
+	// input untouched
+	csr_build_core(G);
+
 	size_t size = G.VC.V.size() + reserved;
 
+	// start with a good cover, the search only looks for smaller ones
+	vc_heuristic(G, sol);
+	u = sol.size();
+
+	incumbent = u;
+	pool_start(CONFIG_THREADS);
+
 	vc_branch_v2(G, sol, size, u);
 
+	pool_stop();
+
+	// the search didn't finish, sol is just the best cover so far
+	if (TIME_stop) {
+		long long lower = min<long long>(size + vc_kernel_lower_bound(G), sol.size());
+		cout << "c search interrupted" << endl;
+		cout << "c lower bound: " << lower << endl;
+	}
+
 	cout << "c VC size = " << sol.size() << endl;
 	cout << "c recursive steps: " << G.recursive_steps << endl;
+	cout << "c trail entries undone: " << G.trail_undone << endl;
 	cout << "s vc " << n << " " << sol.size() << endl;
 
 	for (Vertex *v: sol) {
 		assert(v->downcast == nullptr);
-		cout << v->name << endl;
+		cout << G.vertex_name(v) << endl;
 	}
 }
@@ -13,3 +13,8 @@ extern bool CONFIG_COMPONENTS;
 extern bool CONFIG_BRANCHING_V2;
 extern bool CONFIG_LP_BOUND;
 extern bool CONFIG_CLIQUE_BOUND;
+
+// number of threads searching the branch and bound tree
+extern size_t CONFIG_THREADS;
+// smallest graph a subtree is handed to another thread for
+extern size_t PARALLEL_CUTOFF;
@@ -3,6 +3,7 @@
 #include <cstdlib>
 
 #include "clique.h"
+#include "stats.h"
 
 
 int    CLIQUE_BOUND_ITER         = 1;
@@ -11,64 +12,92 @@ bool   CLIQUE_BOUND_MIXED        = false;
 size_t CLIQUE_BOUND_SHUFFLE_PCT  = 50;
 float  CLIQUE_BOUND_SHUFFLE_DIST = 0.3;
 
-Vertex *find_leader_marked(Vertex *v) {
-	if (!v->marked)
-		return nullptr;
+// the cliques are linked lists of their members ending in the leader vertex,
+// everything is by Vertex::id so that clean rows of Graph::core are walked
+// without touching the vertices
+#define CQ_NONE ((size_t) -1)
 
-	if (v->next_member == nullptr)
-		return v;
-	return find_leader_marked(v->next_member);
-	
+struct clique_data {
+	size_t next_member;
+	size_t clique_size; // only relevant for the leader vertex
+	bool marked;
+};
+
+// indexed by Vertex::id, only allocated once clique_bound runs
+static thread_local vector<clique_data> members;
+
+static inline clique_data &CQ(Vertex *v) {
+	return members[v->id];
 }
 
-void join_largest_clique(Vertex *a) {
-	// mark all neighbours
-	for (auto it = a->edges.begin(); it != a->edges.end(); it++) {
-		Vertex *b = it->first;
-		assert(!b->marked);
-		b->marked = true;
+size_t find_leader_marked(size_t v) {
+	while (members[v].marked) {
+		if (members[v].next_member == CQ_NONE)
+			return v;
+		v = members[v].next_member;
 	}
+	return CQ_NONE;
+}
 
-	pair<size_t, Vertex *> largest(0, nullptr);
+template<typename F>
+static inline void for_each_neighbour_id(Graph &G, Vertex *a, F f) {
+	if (core_clean(G, a)) {
+		const CSRGraph &C = G.core;
+		for (const uint32_t *w = C.begin(a->id); w != C.end(a->id); w++) {
+			if (C.alive[*w])
+				f((size_t) *w);
+		}
+	}
+	else {
+		for (auto it = a->edges.begin(); it != a->edges.end(); it++)
+			f(it->first->id);
+	}
+}
+
+void join_largest_clique(Graph &G, Vertex *a) {
+	// mark all neighbours
+	for_each_neighbour_id(G, a, [](size_t b) {
+		assert(!members[b].marked);
+		members[b].marked = true;
+	});
+
+	pair<size_t, size_t> largest(0, CQ_NONE);
 
 	// find largest clique we can join
-	for (auto it = a->edges.begin(); it != a->edges.end(); it++) {
-		Vertex *b = it->first;
-		if (b->clique_size != 1)
-			continue;
+	for_each_neighbour_id(G, a, [&](size_t b) {
+		if (members[b].clique_size != 1)
+			return;
 
-		Vertex *leader = find_leader_marked(b);
-		if (leader == nullptr)
-			continue;
+		size_t leader = find_leader_marked(b);
+		if (leader == CQ_NONE)
+			return;
 
-		assert(leader->clique_size <= a->edges.size());
+		assert(members[leader].clique_size <= a->edges.size());
 
-		if (leader->clique_size > largest.first) {
-			largest.first  = leader->clique_size;
+		if (members[leader].clique_size > largest.first) {
+			largest.first  = members[leader].clique_size;
 			largest.second = b;
 		}
-	
-	}
+	});
 
 	// join largest clique
-	for (Vertex *b = largest.second; b != nullptr; b = b->next_member) {
-		b->clique_size++;
+	for (size_t b = largest.second; b != CQ_NONE; b = members[b].next_member) {
+		members[b].clique_size++;
 	}
 
-	a->next_member = largest.second;
+	CQ(a).next_member = largest.second;
 
 	// unmark neighbours
-	for (auto it = a->edges.begin(); it != a->edges.end(); it++) {
-		Vertex *b = it->first;
-		assert(b->marked);
-		b->marked = false;
-	}
+	for_each_neighbour_id(G, a, [](size_t b) {
+		assert(members[b].marked);
+		members[b].marked = false;
+	});
 }
 
 
 void clique_bound_sort(Graph &G, vector<Vertex *> &array) {
-	static vector<Vertex *> bucket[30];
-	static vector<Vertex *> high_deg;
+	static thread_local vector<Vertex *> bucket[30];
+	static thread_local vector<Vertex *> high_deg;
 	static struct vertex_cmp cmp;
 
 	for (Vertex *v: G.V) {
@@ -106,9 +135,12 @@ void clique_bound_shuffle(vector<Vertex *> &array) {
 }
 
 long long clique_bound(Graph &G) {	
+	stat_scope scope(G, STAT_CLIQUE_BOUND);
 
-	static vector<Vertex *> array;
+	static thread_local vector<Vertex *> array;
 	array.reserve(G.V.size());
+	if (members.size() < G.n)
+		members.resize(G.n);
 
 	clique_bound_sort(G, array);
 	
@@ -125,8 +157,9 @@ long long clique_bound(Graph &G) {
 		
 		for (size_t i = 0; i < array.size(); i++) {
 			Vertex *v = array[i];
-			v->next_member = nullptr;
-			v->clique_size = 1;
+			CQ(v).next_member = CQ_NONE;
+			CQ(v).clique_size = 1;
+			CQ(v).marked = false;
 		}
 
 		for (size_t i = 0; i < array.size(); i++) {
@@ -138,16 +171,16 @@ long long clique_bound(Graph &G) {
 
 			Vertex *v = array[j];
 
-			if (v->clique_size > 1)
+			if (CQ(v).clique_size > 1)
 				continue;
 
-			join_largest_clique(v);
+			join_largest_clique(G, v);
 		}
 
 		for (size_t i = 0; i < array.size(); i++) {
 			Vertex *v = array[i];
-			if (v->next_member == nullptr)
-				bound += v->clique_size - 1;
+			if (CQ(v).next_member == CQ_NONE)
+				bound += CQ(v).clique_size - 1;
 		}
 
 		best = max(best, bound);
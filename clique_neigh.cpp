@@ -259,7 +259,7 @@ bool cn_find_partition(Graph &G, Vertex *v, vector< pair<Vertex *, Vertex *> > &
 }
 
 void cn_create_edge(Graph &G, GM_clique_neigh *op, Vertex *a, Vertex *b) {
-	Edge *e = new Edge(G.m, a, b);
+	Edge *e = arena_new<Edge>(G.arena, G.m, a, b);
 	G.m++;
 	
 	G.E.push_back(e);
@@ -267,6 +267,9 @@ void cn_create_edge(Graph &G, GM_clique_neigh *op, Vertex *a, Vertex *b) {
 	it--;
 	e->iterE = it;
 
+	core_touch(G, a);
+	core_touch(G, b);
+
 	// the Edge constructor increases deg but we don't want that,
 	// rather vert_change_deg should handle it
 	a->deg--;
@@ -279,7 +282,7 @@ void cn_create_edge(Graph &G, GM_clique_neigh *op, Vertex *a, Vertex *b) {
 }
 
 GM_clique_neigh *cn_setup(Graph &G, Vertex *v, vector< pair<Vertex *, Vertex *> > &C1, vector<Vertex *> &C2) {
-	GM_clique_neigh *op = new GM_clique_neigh();
+	GM_clique_neigh *op = arena_new<GM_clique_neigh>(G.arena);
 	op->v = v;
 
 	// move C1 and C2 into op without copying anything
@@ -343,7 +346,7 @@ bool vc_clique_neigh_single(Graph &G, Vertex *v, long long &k) {
 		for (Vertex *b: op->C2)
 			delete_vertex(G, b);
 
-		G.changes.push_back(op);
+		trail_push(G, TRAIL_CLIQUE_NEIGH, op);
 
 		// cleanup
 		for (auto pair: op->C1)
@@ -383,7 +386,6 @@ void GM_clique_neigh::undo(Graph &G) {
 		vert_change_deg(G, a, a->deg - 1);
 		vert_change_deg(G, b, b->deg - 1);
 		bp_edge_delete_callback(G, e);
-		delete e;
 	}
 }
 
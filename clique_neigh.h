@@ -3,10 +3,10 @@
 #include "graph.h"
 #include "snapshot.h"
 
-class GM_clique_neigh : public GraphModification {
+class GM_clique_neigh {
 public:
-	virtual void undo(Graph &G);
-	virtual void translate_vc(Graph &G, list<Vertex *> &sol);
+	void undo(Graph &G);
+	void translate_vc(Graph &G, list<Vertex *> &sol);
 
 
 	Vertex *v = nullptr;
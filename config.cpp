@@ -10,6 +10,10 @@
 #include "clique.h"
 #include "deg3.h"
 #include "bipart.h"
+#include "heuristic.h"
+#include "local_search.h"
+#include "time.h"
+#include "stats.h"
 
 static vector<string> split(const string& str, const string& delim)
 {
@@ -67,6 +71,14 @@ void read_config_from_file(char *file) {
 			CONFIG_CLIQUE_BOUND = config[1] == "true";
 		}
 
+		// PARALLEL
+		else if (config[0] == "CONFIG_THREADS") {
+			CONFIG_THREADS = stoull(config[1]);
+		}
+		else if (config[0] == "PARALLEL_CUTOFF") {
+			PARALLEL_CUTOFF = stoull(config[1]);
+		}
+
 
 		// RULES
 		else if (config[0] == "CONFIG_RULE") {
@@ -155,10 +167,55 @@ void read_config_from_file(char *file) {
 		}
 
 		
+		// TIME
+		else if (config[0] == "TIME_LIMIT") {
+			TIME_LIMIT = stod(config[1]);
+		}
+		else if (config[0] == "TIME_CHECK_STEPS") {
+			TIME_CHECK_STEPS = max(stoull(config[1]), 1ull);
+		}
+
+		// HEURISTIC
+		else if (config[0] == "HEURISTIC_TIME") {
+			HEURISTIC_TIME = stod(config[1]);
+		}
+		else if (config[0] == "HEURISTIC_ROUNDS") {
+			HEURISTIC_ROUNDS = stoull(config[1]);
+		}
+		else if (config[0] == "HEURISTIC_LS_STEPS") {
+			HEURISTIC_LS_STEPS = stoull(config[1]);
+		}
+
+		// LOCAL SEARCH
+		else if (config[0] == "CONFIG_LOCAL_SEARCH") {
+			CONFIG_LOCAL_SEARCH = config[1] == "true";
+		}
+		else if (config[0] == "LS_TIME") {
+			LS_TIME = stod(config[1]);
+		}
+		else if (config[0] == "LS_TARGET") {
+			LS_TARGET = stoull(config[1]);
+		}
+		else if (config[0] == "LS_SAMPLES") {
+			LS_SAMPLES = stoull(config[1]);
+		}
+
 		// LP BOUND
 		else if (config[0] == "LP_BOUND_CUTOFF") {
 			LP_BOUND_CUTOFF = stof(config[1]);
 		}
+		else if (config[0] == "LP_ENGINE") {
+			if (config[1] == "HK") {
+				LP_ENGINE = LP_ENGINE_HK;
+			}
+			else if (config[1] == "DINIC") {
+				LP_ENGINE = LP_ENGINE_DINIC;
+			}
+			else {
+				cout << "Unknown LP engine " << config[1] << endl;
+				exit(1);
+			}
+		}
 
 
 		// CLIQUE BOUND
@@ -187,6 +244,25 @@ void read_config_from_file(char *file) {
 			UNCONF_MAX_DEG = stoull(config[1]);
 		}
 
+		// PREOPTIMIZATION
+		else if (config[0] == "PREOPT_MAX_ROUNDS") {
+			PREOPT_MAX_ROUNDS = stoull(config[1]);
+		}
+		else if (config[0] == "PREOPT_MIN_RATE") {
+			PREOPT_MIN_RATE = stod(config[1]);
+		}
+		else if (config[0] == "PREOPT_PATIENCE") {
+			PREOPT_PATIENCE = stoull(config[1]);
+		}
+
+		// STATISTICS
+		else if (config[0] == "STATS_JSON") {
+			STATS_JSON = config[1];
+		}
+		else if (config[0] == "SEARCH_CSV") {
+			SEARCH_CSV = config[1];
+		}
+
 
 		else {
 			cout << "Unknown option " << config[0] << endl;
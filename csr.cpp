@@ -0,0 +1,86 @@
+#include <cassert>
+#include <algorithm>
+
+#include "graph.h"
+#include "csr.h"
+
+void csr_build(CSRGraph &C, vector<Vertex *> &verts, const vector<uint64_t> &edges) {
+	C.n = verts.size();
+	C.m = edges.size();
+	C.vertex = verts;
+
+	// count degrees
+	C.offset.assign(C.n + 1, 0);
+	for (uint64_t e: edges) {
+		C.offset[(e >> 32) + 1]++;
+		C.offset[(e & 0xffffffff) + 1]++;
+	}
+
+	C.deg.resize(C.n);
+	for (uint32_t i = 0; i < C.n; i++) {
+		C.deg[i] = C.offset[i + 1];
+		C.offset[i + 1] += C.offset[i];
+		C.vertex[i]->csr_id = i;
+	}
+
+	// fill in the neighbours, pos[i] is the next free slot of i
+	vector<size_t> pos(C.offset.begin(), C.offset.end() - 1);
+	C.adj.resize(2 * C.m);
+	for (uint64_t e: edges) {
+		uint32_t a = e >> 32;
+		uint32_t b = e & 0xffffffff;
+
+		C.adj[pos[a]++] = b;
+		C.adj[pos[b]++] = a;
+	}
+}
+
+void csr_build(CSRGraph &C, Graph &G) {
+	vector<Vertex *> verts(G.V.begin(), G.V.end());
+	vector<uint64_t> edges;
+
+	for (size_t i = 0; i < verts.size(); i++)
+		verts[i]->csr_id = i;
+
+	for (Vertex *v: verts) {
+		for (auto edge: v->edges) {
+			Vertex *u = edge.first;
+			if (v->csr_id < u->csr_id)
+				edges.push_back((uint64_t) v->csr_id << 32 | u->csr_id);
+		}
+	}
+
+	csr_build(C, verts, edges);
+}
+
+void csr_build_core(Graph &G) {
+	CSRGraph &C = G.core;
+	C.n = G.n;
+
+	// the rules leave holes in the ids, their vertex is nullptr
+	C.vertex.assign(C.n, nullptr);
+	C.deg.assign(C.n, 0);
+	C.alive.assign(C.n, 0);
+	for (Vertex *v: G.V) {
+		assert(v->id < C.n);
+		C.vertex[v->id] = v;
+		C.deg[v->id]    = v->deg;
+		C.alive[v->id]  = v->deg > 0;
+	}
+
+	C.offset.assign(C.n + 1, 0);
+	for (uint32_t i = 0; i < C.n; i++)
+		C.offset[i + 1] = C.offset[i] + C.deg[i];
+	C.m = C.offset[C.n] / 2;
+
+	C.adj.resize(C.offset[C.n]);
+	for (Vertex *v: G.V) {
+		uint32_t *row = C.adj.data() + C.offset[v->id];
+		for (size_t j = 0; j < v->edges.size(); j++)
+			row[j] = v->edges[j].first->id;
+		sort(row, row + v->edges.size());
+	}
+
+	C.clean.assign(C.n, 1);
+	C.mark.assign(C.n, 0);
+}
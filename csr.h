@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+using namespace std;
+
+class Vertex;
+class Graph;
+
+// immutable adjacency in compressed sparse row format
+// the neighbours of i are adj[offset[i]] ... adj[offset[i + 1] - 1]
+//
+// Vertices are numbered 0..n-1, vertex[i] is the corresponding Vertex.
+// csr_build sets Vertex::csr_id to i, until the next CSR is built from it
+//
+// in Graph::core i is Vertex::id instead, vertex[i] is nullptr for the ids
+// not in G.V when it was built. The arrays below sit on top of it
+class CSRGraph {
+public:
+	uint32_t n = 0;
+	size_t   m = 0;
+
+	vector<size_t>   offset;
+	vector<uint32_t> adj;
+	vector<Vertex *> vertex;
+
+	// degree of i, kept up to date by vert_change_deg for Graph::core
+	vector<uint32_t> deg;
+
+	/* only for Graph::core */
+	// i still has edges, vert_change_deg keeps it up to date
+	vector<uint8_t> alive;
+	// the neighbours of i are the alive vertices of its row. Cleared by
+	// core_touch once a rule adds or moves an edge of i, the trail sets it
+	// again
+	vector<uint8_t> clean;
+	// scratch for the rules, all zero when a rule is done with it
+	vector<uint8_t> mark;
+
+	const uint32_t *begin(uint32_t i) const { return adj.data() + offset[i]; }
+	const uint32_t *end(uint32_t i)   const { return adj.data() + offset[i + 1]; }
+};
+
+// build from a list of edges (a << 32 | b) between the vertices in verts
+// an edge a-b is stored in both directions
+void csr_build(CSRGraph &C, vector<Vertex *> &verts, const vector<uint64_t> &edges);
+
+// build from the uncovered edges of the vertices in G.V
+void csr_build(CSRGraph &C, Graph &G);
+
+// build G.core from the vertices of G.V and their uncovered edges, every
+// vertex is clean afterwards. The rows are sorted
+void csr_build_core(Graph &G);
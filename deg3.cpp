@@ -57,20 +57,20 @@ bool deg3_is_check_feasability(Graph &G, Vertex *v, Vertex *a, Vertex *b, Vertex
 }
 
 // return the number of edges in G[{a, b, c}]
-int deg3_num_edges(Vertex *a, Vertex *b, Vertex *c) {
+// d3_deg[i] is set to the degree of the i-th vertex in G[{a, b, c}]
+int deg3_num_edges(Vertex *a, Vertex *b, Vertex *c, size_t d3_deg[3]) {
 	Vertex *S[] = {a, b, c};
 	int n = 0;
 
 	for (int i = 0; i < 3; i++) {
 		Vertex *v = S[i];
+		d3_deg[i] = 0;
 
 		for (auto edge: v->edges) {
 			Vertex *u = edge.first;
 
 			if (u == a || u == b || u == c) {
-				// we don't actually make a new edge object
-				// so this is only to make lookups faster
-				v->d3_edges.push_back(edge);
+				d3_deg[i]++;
 				n++;
 			}
 		}
@@ -81,7 +81,7 @@ int deg3_num_edges(Vertex *a, Vertex *b, Vertex *c) {
 
 
 void deg3_create_edge(Graph &G, GM_deg3 *op, Vertex *u, Vertex *w) {
-	Edge *e = new Edge(G.m, u, w);
+	Edge *e = arena_new<Edge>(G.arena, G.m, u, w);
 	
 	G.E.push_back(e);
 	auto it = G.E.end();
@@ -89,6 +89,9 @@ void deg3_create_edge(Graph &G, GM_deg3 *op, Vertex *u, Vertex *w) {
 	e->iterE = it;
 
 	G.m++;
+	core_touch(G, u);
+	core_touch(G, w);
+
 	// the Edge constructor increases deg but we don't want that
 	u->deg--;
 	w->deg--;
@@ -102,7 +105,7 @@ bool deg3_independent_set(Graph &G, Vertex *v, Vertex *a, Vertex *b, Vertex *c)
 	if (!deg3_is_check_feasability(G, v, a, b, c))
 		return false;
 
-	GM_deg3 *op = new GM_deg3(v, a, b, c);
+	GM_deg3 *op = arena_new<GM_deg3>(G.arena, v, a, b, c);
 
 	delete_vertex(G, v);
 
@@ -171,12 +174,12 @@ bool deg3_independent_set(Graph &G, Vertex *v, Vertex *a, Vertex *b, Vertex *c)
 	vert_mark_uncertain(G, c);
 
 	// register graph transformation
-	G.changes.push_back(op);
+	trail_push(G, TRAIL_DEG3, op);
 
 	return true;
 }
 
-void deg3_domination(Graph &G, Vertex *a, Vertex *b, Vertex *c) {
+void deg3_domination(Graph &G, Vertex *a, Vertex *b, Vertex *c, size_t d3_deg[3]) {
 	Vertex *S[] = {a, b, c};
 	Vertex *max = nullptr;
 
@@ -184,13 +187,12 @@ void deg3_domination(Graph &G, Vertex *a, Vertex *b, Vertex *c) {
 	for (int i = 0; i < 3; i++) {
 		Vertex *u = S[i];
 
-		if (u->d3_edges.size() >= 2) {
+		if (d3_deg[i] >= 2) {
 			if (max == nullptr || u->edges.size() > max->edges.size())
 				max = u;
 		}
 	}
 	assert(max != nullptr);
-	assert(max->d3_edges.size() >= 2);
 
 	add_to_vc(G, max);
 }
@@ -199,22 +201,18 @@ void deg3_domination(Graph &G, Vertex *a, Vertex *b, Vertex *c) {
 bool vc_deg3_rule(Graph &G, long long &k) {
 	bool rerun;
 	bool ran = false;
+	vector<Vertex *> todo;
 
 	do {
 		rerun = false;
 
 		/* find deg 3 vertices */
-		for (auto it = G.deg3s.begin(); it != G.deg3s.end(); ) {
-			Vertex *v = *it;
-			auto next = it;
-			next++;
-			it++;
-			Vertex *tmp = nullptr;
-			// keep track of the position in the list, because
-			// the list can get mangled in all sorts of ways
-			it = G.deg3s.insert(it, tmp);
-
-			
+		// the rule changes G.deg3s, go through a copy
+		todo.assign(G.deg3s.begin(), G.deg3s.end());
+		for (Vertex *v: todo) {
+			if (v->deg != 3)
+				continue;
+
 			assert(v->edges.size() == 3);
 			auto it2 = v->edges.begin();
 
@@ -225,7 +223,8 @@ bool vc_deg3_rule(Graph &G, long long &k) {
 			it2++;
 			Vertex *c = it2->first;
 
-			int n_edges = deg3_num_edges(a, b, c);
+			size_t d3_deg[3];
+			int n_edges = deg3_num_edges(a, b, c, d3_deg);
 
 
 			if (n_edges == 0) {
@@ -234,12 +233,6 @@ bool vc_deg3_rule(Graph &G, long long &k) {
 					ran   = true;
 				}
 			}
-
-			a->d3_edges.clear();
-			b->d3_edges.clear();
-			c->d3_edges.clear();
-
-			it = G.deg3s.erase(it);
 		}
 	} while (rerun);
 
@@ -274,7 +267,6 @@ void GM_deg3::undo(Graph &G) {
 		vert_change_deg(G, x, x->deg - 1);
 		vert_change_deg(G, y, y->deg - 1);
 		bp_edge_delete_callback(G, e);
-		delete e;
 	}
 }
 
@@ -3,10 +3,10 @@
 #include "graph.h"
 #include "snapshot.h"
 
-class GM_deg3 : public GraphModification {
+class GM_deg3 {
 public:
-	virtual void undo(Graph &G);
-	virtual void translate_vc(Graph &G, list<Vertex *> &sol);
+	void undo(Graph &G);
+	void translate_vc(Graph &G, list<Vertex *> &sol);
 
 	GM_deg3(Vertex *V, Vertex *A, Vertex *B, Vertex *C) : v(V), a(A), b(B), c(C) {};
 
@@ -0,0 +1,116 @@
+#include <vector>
+
+#include "flow.h"
+
+// layers of the left vertices in the residual graph
+static thread_local vector<uint32_t> dist;
+// current arc of each left vertex within a phase
+static thread_local vector<size_t> arc;
+static thread_local vector<uint32_t> queue;
+static thread_local vector<uint32_t> stack;
+
+/* BFS from the free left vertices, a left vertex is followed by the partners
+ * of its right neighbours. Stops at the first layer reaching a free right
+ * vertex, returns false if there is none
+ */
+static bool flow_bfs(const CSRGraph &C, const vector<uint32_t> &match_l, const vector<uint32_t> &match_r) {
+	uint32_t limit = FLOW_NONE;
+
+	queue.clear();
+	for (uint32_t i = 0; i < C.n; i++) {
+		if (match_l[i] == FLOW_NONE) {
+			dist[i] = 0;
+			queue.push_back(i);
+		}
+		else {
+			dist[i] = FLOW_NONE;
+		}
+	}
+
+	for (size_t q = 0; q < queue.size(); q++) {
+		uint32_t i = queue[q];
+		if (dist[i] >= limit)
+			break;
+
+		for (const uint32_t *j = C.begin(i); j != C.end(i); j++) {
+			uint32_t k = match_r[*j];
+
+			if (k == FLOW_NONE) {
+				limit = dist[i] + 1;
+			}
+			else if (dist[k] == FLOW_NONE) {
+				dist[k] = dist[i] + 1;
+				queue.push_back(k);
+			}
+		}
+	}
+
+	return limit != FLOW_NONE;
+}
+
+/* find an augmenting path from the free left vertex root along the layers
+ * and flip the matching along it. Edges that lead nowhere are skipped for
+ * the rest of the phase
+ */
+static bool flow_dfs(const CSRGraph &C, vector<uint32_t> &match_l, vector<uint32_t> &match_r, uint32_t root) {
+	stack.clear();
+	stack.push_back(root);
+
+	while (!stack.empty()) {
+		uint32_t i = stack.back();
+
+		if (arc[i] == C.offset[i + 1]) {
+			// dead end
+			dist[i] = FLOW_NONE;
+			stack.pop_back();
+			if (!stack.empty())
+				arc[stack.back()]++;
+			continue;
+		}
+
+		uint32_t j = C.adj[arc[i]];
+		uint32_t k = match_r[j];
+
+		if (k == FLOW_NONE) {
+			for (uint32_t a: stack) {
+				uint32_t b = C.adj[arc[a]];
+				match_l[a] = b;
+				match_r[b] = a;
+			}
+			return true;
+		}
+
+		if (dist[k] != FLOW_NONE && dist[k] == dist[i] + 1)
+			stack.push_back(k);
+		else
+			arc[i]++;
+	}
+
+	return false;
+}
+
+void flow_vertex_cover(const CSRGraph &C, vector<uint32_t> &match_l, vector<uint32_t> &match_r, vector<uint8_t> &reach) {
+	dist.resize(C.n);
+	arc.resize(C.n);
+
+	// one phase finds a blocking flow of shortest augmenting paths
+	while (flow_bfs(C, match_l, match_r)) {
+		for (uint32_t i = 0; i < C.n; i++)
+			arc[i] = C.offset[i];
+
+		for (uint32_t i = 0; i < C.n; i++) {
+			if (match_l[i] == FLOW_NONE && dist[i] == 0)
+				flow_dfs(C, match_l, match_r, i);
+		}
+	}
+
+	// the last BFS didn't stop early, dist is set for every left vertex
+	// reachable from a free one. All their neighbours are reachable too
+	reach.assign(C.n, 0);
+	for (uint32_t i = 0; i < C.n; i++) {
+		if (dist[i] == FLOW_NONE)
+			continue;
+		for (const uint32_t *j = C.begin(i); j != C.end(i); j++)
+			reach[*j] = 1;
+	}
+}
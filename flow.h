@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "csr.h"
+using namespace std;
+
+// an unmatched vertex in flow_vertex_cover
+#define FLOW_NONE numeric_limits<uint32_t>::max()
+
+/* maximum matching of the bipartite double cover of C with Dinic's algorithm
+ * left vertex i is matched to the right vertex match_l[i] and right vertex j
+ * to the left vertex match_r[j], or FLOW_NONE. The matching passed in has to
+ * be valid and is used as the starting point.
+ *
+ * afterwards reach[j] is set for the right vertices reachable from a free
+ * left vertex over alternating paths. With König's theorem the minimum
+ * vertex cover of the double cover are those, together with the partners of
+ * the other matched right vertices
+ */
+void flow_vertex_cover(const CSRGraph &C, vector<uint32_t> &match_l, vector<uint32_t> &match_r, vector<uint8_t> &reach);
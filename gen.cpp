@@ -0,0 +1,259 @@
+// Instance generator: writes a random graph in the PACE .gr format to
+// stdout. The same family, parameters and seed give the same file on every
+// platform, the random numbers are drawn from mt19937_64 without the
+// implementation defined std distributions.
+//
+// Usage: gen family [-n vertices] [-d avg degree] [-s seed] [options]
+//   er       Erdos-Renyi G(n, m) with m = n * d / 2
+//   geo      random geometric graph in the unit square, radius chosen for
+//            an expected degree of d
+//   chunglu  Chung-Lu graph with power law degrees, exponent -g (2.5)
+//   ba       Barabasi-Albert, every new vertex attaches to d / 2 others
+//   grid     -x by -y grid, every cell gets a diagonal with probability -p
+//            (0), so it stays planar
+//   planted  n * d / 2 edges that all touch a hidden cover of -k vertices
+//   comps    -c (10) disjoint er components of n vertices each
+#include <iostream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <random>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+
+#include <unistd.h>
+
+using namespace std;
+
+struct gen_params {
+	size_t n = 1000;
+	double d = 4;       // average degree
+	double g = 2.5;     // power law exponent
+	double p = 0;       // diagonal probability of grid
+	size_t x = 0, y = 0; // grid size
+	size_t k = 0;       // size of the planted cover
+	size_t c = 10;      // number of components
+	uint64_t seed = 1;
+};
+
+static mt19937_64 rng;
+
+// uniform in [0, n)
+static inline uint64_t gen_int(uint64_t n) {
+	return (uint64_t) (((unsigned __int128) rng() * n) >> 64);
+}
+
+// uniform in [0, 1)
+static inline double gen_real() {
+	return (rng() >> 11) / 9007199254740992.0; // 2^53
+}
+
+// 0 based vertices, sorted and deduplicated before writing
+typedef vector<pair<uint32_t, uint32_t>> edge_list;
+
+static inline void add_edge(edge_list &E, uint32_t a, uint32_t b) {
+	if (a == b)
+		return;
+	E.push_back(a < b ? make_pair(a, b) : make_pair(b, a));
+}
+
+static void write_graph(size_t n, edge_list &E, const string &comment) {
+	sort(E.begin(), E.end());
+	E.erase(unique(E.begin(), E.end()), E.end());
+
+	cout << "c " << comment << "\n";
+	cout << "p td " << n << " " << E.size() << "\n";
+	for (auto &e: E)
+		cout << e.first + 1 << " " << e.second + 1 << "\n";
+}
+
+static size_t n_edges(const gen_params &P) {
+	return (size_t) llround(P.n * P.d / 2);
+}
+
+// G(n, m), duplicates are dropped so there may be a few less than m
+static void gen_er(edge_list &E, size_t n, size_t m, uint32_t offset) {
+	if (n < 2)
+		return;
+	for (size_t i = 0; i < m; i++)
+		add_edge(E, offset + gen_int(n), offset + gen_int(n));
+}
+
+static void gen_geo(edge_list &E, const gen_params &P) {
+	double r = sqrt(P.d / (acos(-1) * P.n));
+	size_t cells = max<size_t>(1, (size_t) (1 / r));
+
+	vector<double> px(P.n), py(P.n);
+	vector<vector<uint32_t>> grid(cells * cells);
+	for (size_t i = 0; i < P.n; i++) {
+		px[i] = gen_real();
+		py[i] = gen_real();
+		grid[min(cells - 1, (size_t) (py[i] * cells)) * cells + min(cells - 1, (size_t) (px[i] * cells))].push_back(i);
+	}
+
+	// the cells are at least r wide, so the neighbours are in the 3x3 block
+	for (size_t cy = 0; cy < cells; cy++) {
+		for (size_t cx = 0; cx < cells; cx++) {
+			for (uint32_t a: grid[cy * cells + cx]) {
+				for (size_t ny = cy > 0 ? cy - 1 : 0; ny <= min(cells - 1, cy + 1); ny++) {
+					for (size_t nx = cx > 0 ? cx - 1 : 0; nx <= min(cells - 1, cx + 1); nx++) {
+						for (uint32_t b: grid[ny * cells + nx]) {
+							double dx = px[a] - px[b], dy = py[a] - py[b];
+							if (a < b && dx * dx + dy * dy <= r * r)
+								add_edge(E, a, b);
+						}
+					}
+				}
+			}
+		}
+	}
+}
+
+static void gen_chunglu(edge_list &E, const gen_params &P) {
+	// weight of vertex i proportional to (i + 1)^(-1 / (g - 1)), the endpoints
+	// of every edge are drawn by weight
+	vector<double> cumulative(P.n);
+	double sum = 0;
+	for (size_t i = 0; i < P.n; i++) {
+		sum += pow(i + 1, -1 / (P.g - 1));
+		cumulative[i] = sum;
+	}
+
+	auto draw = [&]() {
+		double w = gen_real() * sum;
+		return (uint32_t) min<size_t>(P.n - 1, upper_bound(cumulative.begin(), cumulative.end(), w) - cumulative.begin());
+	};
+
+	size_t m = n_edges(P);
+	for (size_t i = 0; i < m; i++)
+		add_edge(E, draw(), draw());
+}
+
+static void gen_ba(edge_list &E, const gen_params &P) {
+	size_t per = max<size_t>(1, (size_t) llround(P.d / 2));
+
+	// every vertex once per incident edge, drawing from it is preferential
+	vector<uint32_t> ends;
+	for (size_t v = 1; v < P.n; v++) {
+		for (size_t i = 0; i < min(per, v); i++) {
+			uint32_t u = ends.empty() ? gen_int(v) : ends[gen_int(ends.size())];
+			add_edge(E, v, u);
+			ends.push_back(v);
+			ends.push_back(u);
+		}
+	}
+}
+
+static void gen_grid(edge_list &E, const gen_params &P) {
+	for (size_t i = 0; i < P.y; i++) {
+		for (size_t j = 0; j < P.x; j++) {
+			uint32_t v = i * P.x + j;
+			if (j + 1 < P.x)
+				add_edge(E, v, v + 1);
+			if (i + 1 < P.y)
+				add_edge(E, v, v + P.x);
+			if (i + 1 < P.y && j + 1 < P.x && gen_real() < P.p) {
+				if (gen_int(2))
+					add_edge(E, v, v + P.x + 1);
+				else
+					add_edge(E, v + 1, v + P.x);
+			}
+		}
+	}
+}
+
+static void gen_planted(edge_list &E, const gen_params &P) {
+	vector<uint32_t> perm(P.n);
+	for (size_t i = 0; i < P.n; i++)
+		perm[i] = i;
+	for (size_t i = P.n - 1; i > 0; i--)
+		swap(perm[i], perm[gen_int(i + 1)]);
+
+	// perm[0, k) is the cover, every edge has one end in it
+	size_t m = n_edges(P);
+	for (size_t i = 0; i < m; i++)
+		add_edge(E, perm[gen_int(P.k)], perm[gen_int(P.n)]);
+}
+
+static void usage(const char *argv0) {
+	cerr << "Usage: " << argv0 << " er|geo|chunglu|ba|grid|planted|comps [-n vertices] [-d avg degree] [-s seed]" << endl
+	     << "       [-g exponent] [-x width] [-y height] [-p diagonal probability] [-k cover] [-c components]" << endl;
+	exit(2);
+}
+
+int main(int argc, char **argv) {
+	if (argc < 2)
+		usage(argv[0]);
+	string family = argv[1];
+
+	gen_params P;
+	int opt;
+	optind = 2;
+	while ((opt = getopt(argc, argv, "n:d:g:p:x:y:k:c:s:")) != -1) {
+		switch (opt) {
+		case 'n': P.n = stoull(optarg); break;
+		case 'd': P.d = stod(optarg); break;
+		case 'g': P.g = stod(optarg); break;
+		case 'p': P.p = stod(optarg); break;
+		case 'x': P.x = stoull(optarg); break;
+		case 'y': P.y = stoull(optarg); break;
+		case 'k': P.k = stoull(optarg); break;
+		case 'c': P.c = stoull(optarg); break;
+		case 's': P.seed = stoull(optarg); break;
+		default: usage(argv[0]);
+		}
+	}
+	if (optind != argc || P.n == 0)
+		usage(argv[0]);
+
+	rng.seed(P.seed);
+
+	// little performance boost for iostream
+	std::ios::sync_with_stdio(false);
+
+	edge_list E;
+	size_t n = P.n;
+	string comment = family + " n " + to_string(P.n) + " d " + to_string(P.d) + " seed " + to_string(P.seed);
+
+	if (family == "er") {
+		gen_er(E, P.n, n_edges(P), 0);
+	}
+	else if (family == "geo") {
+		gen_geo(E, P);
+	}
+	else if (family == "chunglu") {
+		if (P.g <= 1)
+			usage(argv[0]);
+		gen_chunglu(E, P);
+		comment += " g " + to_string(P.g);
+	}
+	else if (family == "ba") {
+		gen_ba(E, P);
+	}
+	else if (family == "grid") {
+		if (P.x == 0 || P.y == 0)
+			P.x = P.y = (size_t) ceil(sqrt(P.n));
+		n = P.x * P.y;
+		gen_grid(E, P);
+		comment = "grid " + to_string(P.x) + "x" + to_string(P.y) + " p " + to_string(P.p) + " seed " + to_string(P.seed);
+	}
+	else if (family == "planted") {
+		if (P.k == 0 || P.k > P.n)
+			P.k = P.n / 4 + 1;
+		gen_planted(E, P);
+		comment += " cover <= " + to_string(P.k);
+	}
+	else if (family == "comps") {
+		n = P.n * P.c;
+		for (size_t i = 0; i < P.c; i++)
+			gen_er(E, P.n, n_edges(P), i * P.n);
+		comment += " components " + to_string(P.c);
+	}
+	else {
+		usage(argv[0]);
+	}
+
+	write_graph(n, E, comment);
+	return 0;
+}
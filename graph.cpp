@@ -11,13 +11,16 @@
 #include "bipart.h"
 #include "clique.h"
 #include "stats.h"
+#include "heuristic.h"
+#include "time.h"
 
 // a fake vertex used as an object for comparison
-Vertex deg1_vertex(0, "fake_deg1", 1);
+Vertex deg1_vertex(0, NO_LABEL, 1);
 
 // returns true if a VC has been found, if not false and a lower bound is returned
 pair<bool, long long> vc_branch(Graph &G, long long k) {
 	if (G.E.size() == 0) {
+		stats_node(G.depth, NODE_SOLVED);
 		if (k < 0) {
 			return make_pair(false, G.VC.V.size());
 		}
@@ -25,6 +28,10 @@ pair<bool, long long> vc_branch(Graph &G, long long k) {
 		return make_pair(true, 0ll);
 	}
 
+	// out of time, vertex_cover prints the heuristic cover
+	if (time_expired(G.recursive_steps))
+		return make_pair(false, k + 1);
+
 	G.recursive_steps++;
 
 	/* information for rollback */
@@ -34,13 +41,18 @@ pair<bool, long long> vc_branch(Graph &G, long long k) {
 
 	/* compute lower bound */
 	long long lower_bound = 1;	// since we have at least one edge
+	long long lp = 0;
+	long long clique = 0;
 	size_t tmp_vc = G.VC.V.size();
 
-	if (CONFIG_LP_BOUND)
-		lower_bound = max(lower_bound, lp_bound(G)); // modifies the graph
+	if (CONFIG_LP_BOUND) {
+		lp = lp_bound(G); // modifies the graph
+		lower_bound = max(lower_bound, lp);
+	}
 
 	k = k - (G.VC.V.size() - tmp_vc);
 	if (G.E.size() == 0) {
+		stats_node(G.depth, NODE_SOLVED);
 		if (k < 0) {
 			return make_pair(false, G.VC.V.size());
 		}
@@ -48,8 +60,10 @@ pair<bool, long long> vc_branch(Graph &G, long long k) {
 		return make_pair(true, 0ll);
 	}
 
-	if (CONFIG_CLIQUE_BOUND)
-		lower_bound = max(lower_bound, clique_bound(G));
+	if (CONFIG_CLIQUE_BOUND) {
+		clique = clique_bound(G);
+		lower_bound = max(lower_bound, clique);
+	}
 
 	Vertex *v = nullptr;
 	
@@ -58,16 +72,13 @@ pair<bool, long long> vc_branch(Graph &G, long long k) {
 
 	// use lower_bound to give vertex_cover a better prediction for the next k
 	if (k < lower_bound) {
+		stats_node(G.depth, k < lp ? NODE_LP : k < clique ? NODE_CLIQUE : NODE_INCUMBENT);
 		lower_bound = G.VC.V.size() + lower_bound;
 		goto fail;
 	}
 
 	/* select the highest degree vertex */
-	v = G.V.front();
-	for (Vertex *a: G.V) {
-		if (v->deg < a->deg)
-			v = a;
-	}
+	v = G.buckets.max();
 
 	/* simple check if k is too small */
 	if (v->deg <= k) {
@@ -78,12 +89,14 @@ pair<bool, long long> vc_branch(Graph &G, long long k) {
 			k++;
 		}
 		if (ran) {
+			stats_node(G.depth, NODE_K2);
 			lower_bound = G.VC.V.size() + k;
 			goto fail;
 		}
 	}
 
 	lower_bound += G.VC.V.size();
+	stats_node(G.depth, NODE_BRANCHED);
 	for (int i = 0; i < 2; i++) {
 		/* information for rollback */
 		struct graph_snapshot snapshot;
@@ -112,13 +125,15 @@ pair<bool, long long> vc_branch(Graph &G, long long k) {
 		vc_optimize(G, k);	// can decrement k
 
 		// some rules don't add vertices to the VC, but instead reserve
-		// a space (by decrementing k). GraphModification.translate()
+		// a space (by decrementing k). translate_vc() in read_vc
 		// finds which vertex needs to be added
 		bounds[i] = old_k - k;
 
 		/* branch */
 		size_t vc_diff = G.VC.V.size() - old_vc_size;
+		G.depth++;
 		auto found = vc_branch(G, k - vc_diff);
+		G.depth--;
 		if (found.first == true)
 			return found;
 
@@ -130,10 +145,15 @@ pair<bool, long long> vc_branch(Graph &G, long long k) {
 		assert(G.VC.V.size() == old_vc_size);
 		assert(G.VC.E.size() == old_vce_size);
 		assert(G.E.size()    == old_e_size);
+
+		// the bounds of an interrupted search are meaningless
+		if (TIME_stop)
+			goto fail;
 	}	
 
 	// use the result of the branching to improve the lower bound
 	assert(lower_bound <= min(bounds[0], bounds[1]));
+	stats_gap(G.depth, min(bounds[0], bounds[1]) - lower_bound);
 	lower_bound = min(bounds[0], bounds[1]);
 
 fail:
@@ -147,8 +167,6 @@ void vertex_cover(Graph &G, string td, size_t n) {
 	long long k = 0;
 	list<Vertex *> solution;
 
-	/* init */
-	bp_matching_init(G);
 	/* optimize graph */
 	vc_optimize(G, k);
 
@@ -157,6 +175,16 @@ void vertex_cover(Graph &G, string td, size_t n) {
 
 	print_graph_optimization(G);
 
+	// the search starts from the kernel, the rules left few rows of the
+	// input untouched
+	csr_build_core(G);
+
+	// printed instead if the search is interrupted, a cover of the kernel
+	// of size s lifts to one of size s + offset
+	list<Vertex *> fallback;
+	long long offset = vc_heuristic(G, fallback);
+	offset = fallback.size() - offset;
+
 	// save the current VC into a different vector
 	// this has to be done because vc_branch assumes that when it is first
 	// called G.VC.V is empty
@@ -174,6 +202,8 @@ void vertex_cover(Graph &G, string td, size_t n) {
 
 		if (found.first == true)
 			break;
+		if (TIME_stop)
+			break;
 		assert(found.second >= k+1);
 		k = max(k+1, found.second);
 	//	cout << "# k = " << k << endl;
@@ -183,15 +213,91 @@ void vertex_cover(Graph &G, string td, size_t n) {
 	G.VC.V_backup.insert(G.VC.V_backup.end(), G.VC.V.begin(), G.VC.V.end());
 	swap(G.VC.V, G.VC.V_backup);
 
-	// read off the vertex cover for the original graph from the transformed graph
-	read_vc(G, solution);
+	if (TIME_stop) {
+		// every k' < k failed, the kernel needs at least k vertices
+		solution.swap(fallback);
+		cout << "c search interrupted" << endl;
+		cout << "c lower bound: " << min<long long>(k + offset, solution.size()) << endl;
+	}
+	else {
+		// read off the vertex cover for the original graph from the transformed graph
+		read_vc(G, solution);
+	}
 
 	cout << "c VC size = " << solution.size() << endl;
 	cout << "c recursive steps: " << G.recursive_steps << endl;
+	cout << "c trail entries undone: " << G.trail_undone << endl;
 	cout << "s vc " << n << " " << solution.size() << endl;
 
 	for (Vertex *v: solution) {
 		assert(v->downcast == nullptr);
-		cout << v->name << endl;
+		cout << G.vertex_name(v) << endl;
 	}
 }
+
+// put the vertices of G.V into the degree lists and the buckets
+void graph_init_lists(Graph &G) {
+	G.deg1s.clear();
+	G.deg2s.clear();
+	G.deg3s.clear();
+
+	for (Vertex *v: G.V) {
+		if (v->deg == 1)
+			G.deg1s.push_back(v);
+		else if (v->deg == 2)
+			G.deg2s.push_back(v);
+		else if (v->deg == 3)
+			G.deg3s.push_back(v);
+	}
+
+	G.buckets.clear();
+	for (Vertex *v: G.V)
+		G.buckets.insert(v);
+}
+
+/* copy the current graph of src (G.V and the uncovered edges) into the empty
+ * graph dst, dst.core is built from it. origin[i] is src.V[i], its copy has
+ * the id i and the label i + 1. Returns the copies, the one of v is
+ * copy[v->pos_V]
+ */
+vector<Vertex *> graph_copy(Graph &dst, Graph &src, vector<Vertex *> &origin) {
+	origin.assign(src.V.begin(), src.V.end());
+
+	vector<Vertex *> copy(origin.size());
+	for (size_t i = 0; i < origin.size(); i++) {
+		copy[i] = arena_new<Vertex>(dst.arena, i, i + 1);
+		copy[i]->edges.reserve(origin[i]->deg);
+		dst.V.push_back(copy[i]);
+	}
+	dst.n = origin.size();
+
+	for (size_t i = 0; i < origin.size(); i++) {
+		for (auto edge: origin[i]->edges) {
+			size_t j = edge.first->pos_V;
+			if (j < i)
+				continue;
+
+			Edge *e = arena_new<Edge>(dst.arena, dst.m, copy[i], copy[j]);
+			dst.E.push_back(e);
+			auto it = dst.E.end();
+			it--;
+			e->iterE = it;
+			dst.m++;
+		}
+	}
+
+	graph_init_lists(dst);
+	csr_build_core(dst);
+
+	// the copy has the same work left for the rules
+	dst.dirty_active = src.dirty_active;
+	for (size_t i = 0; i < origin.size(); i++) {
+		for (int r = 0; r < NUM_DIRTY; r++) {
+			if (origin[i]->dirty & (1 << r))
+				dst.dirty[r].push_back(copy[i]);
+		}
+		copy[i]->dirty = origin[i]->dirty;
+	}
+
+	return copy;
+}
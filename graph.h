@@ -7,6 +7,7 @@
 #include <list>
 #include <queue>
 #include <string>
+#include <atomic>
 
 using namespace std;
 
@@ -16,14 +17,27 @@ class Graph;
 class MergedVertex;
 
 #include "heap.h"
+#include "csr.h"
+#include "arena.h"
 #include "snapshot.h"
 #include "constraints.h"
 
 
+// label of vertices that don't come from the input (merged vertices etc.)
+#define NO_LABEL 0
+
+// the fields used in the branching hot loop come first, scratch space of
+// individual rules lives in side tables (see Graph::lp) that are only
+// allocated when the rule runs
 class Vertex {
 public:
 	size_t id;
-	string name;
+
+	// here the degree is the number of uncovered edges that are adjacent
+	// meaning deg == edges.size()
+	size_t deg;
+	// position in G.buckets.bucket[deg], see DegreeBuckets
+	size_t bucket_pos;
 
 	// here an edge is a pair of the other vertex and the edge object
 	// edges is the list of not covered edges
@@ -31,39 +45,35 @@ public:
 	vector< pair<Vertex *, Edge *> > edges;
 	vector< pair<Vertex *, Edge *> > covered;
 
-	// list for temporarily holding edges
-	// make sure you clear this if you use it
-	vector< pair<Vertex *, Edge *> > tmp_edges;
-
-	// here the degree is the number of uncovered edges that are adjacent
-	// meaning deg == edges.size()
-	size_t deg;
-
-	// calculated in select.cpp
-	float score = 0.0; // we'll branch on vertices with the highest score
-	bool dont_branch = false;	// if this vertex will be removed by a rule, never branch on it
-
-	// if it's a degree 1 vertex it will be in a list of degree 1 vertices. This is the iterator to it
-	list<Vertex *>::iterator iter1;
-	// if it's a degree 2 vertex it will be in a list of degree 2 vertices. This is the iterator to it
-	list<Vertex *>::iterator iter2;
-	// if it's a degree 3 vertex it will be in a list of degree 3 vertices. This is the iterator to it
-	list<Vertex *>::iterator iter3;
+	// if it's a degree 1, 2 or 3 vertex it will be in G.deg1s, G.deg2s or
+	// G.deg3s. This is its index there
+	size_t pos_deg;
 
-	// if its's a degree > 0 vertex it will be in the list V. This is the iterator to it
-	list<Vertex *>::iterator iterV;
+	// if its's a degree > 0 vertex it will be in G.V. This is its index there
+	size_t pos_V;
 
 	// temporary bool, make sure you reset this back to false if you use it
 	bool marked = false;
 
+	// bit r is set while v is in Graph::dirty[r]
+	uint8_t dirty = 0;
+
+	// used by the unconfined rule
+	bool S_marked = false;
+	bool NS_marked = false;
+
 	// used for checking constrains
 	bool cstr_in_vc = false;
 	bool cstr_uncertain = false;
 
-	// used in read_vc and local_search
+	// used in read_vc
 	bool in_vc = false;			// is this vertex in the vertex cover?
-	list<Vertex *>::iterator iterVC;	// this is the iterator to it
-	bool ls_visited;
+
+	// stuff for clique neighbourhood rule
+	bool in_c1 = false;
+	bool in_c2 = false;
+
+	bool dont_branch = false;	// if this vertex will be removed by a rule, never branch on it
 
 	// the MergedVertex object this vertex has been merged into, or nullptr
 	MergedVertex *merge = nullptr;
@@ -71,50 +81,28 @@ public:
 	// C++ won't let me use dynamic casts
 	MergedVertex *downcast = nullptr;
 
-#if 1
-	// stuff for deg_3 independent set
-	vector< pair<Vertex *, Edge *> > d3_edges;
-#endif
+	/* cold fields */
 
-#if 1
-	// stuff for clique neighbourhood rule
-	bool in_c1 = false;
-	bool in_c2 = false;
-	size_t old_deg = 0;
-#endif
+	// the input label, Graph::vertex_name turns it back into the name
+	size_t label;
 
-#if 1
-	/* stuff for Hopcroft-Karp */
-	Vertex *hk_pair[2];
-	size_t hk_dist;      // left vertex
-	bool hk_alternating; // right vertex
-	bool bp_vc[2];
+	list<Vertex *>::iterator iterVC;	// the iterator to it in the vertex cover
 
-	bool lp_visited[2];
-	bool lp_marked[2];
-	pair<bool, Vertex *> lp_root[2];
-	list< pair<bool, Vertex *> > scc[2];
-#endif
+	// calculated in score.cpp
+	float score = 0.0; // we'll branch on vertices with the highest score
 
-#if 1
-	// stuff for clique
-	Vertex *next_member;
-	size_t clique_size; // only relevant for the leader vertex
-#endif
-	
-	bool S_marked = false;
-	bool NS_marked = false;
+	// index of this vertex in the last CSRGraph built from it, scratch
+	// that every csr_build overwrites
+	uint32_t csr_id;
 
 	size_t component;
 
 
-	virtual ~Vertex() {};
+	Vertex(size_t id, size_t label)
+	: id(id), deg(0), label(label) {};
 
-	Vertex(size_t id, string name)
-	: id(id), name(name), deg(0) {};
-
-	Vertex(size_t id, string name, size_t degree)
-	: id(id), name(name), deg(degree) {};
+	Vertex(size_t id, size_t label, size_t degree)
+	: id(id), deg(degree), label(label) {};
 
 };
 
@@ -158,6 +146,104 @@ public:
 	}
 };
 
+/* a set of vertices in a dense array, v->*pos is the index of v in it.
+ * Nothing is allocated once the array has grown, erase moves the last vertex
+ * into the hole so the order changes. Vertices must not be added or erased
+ * while iterating, copy the array first
+ */
+template <size_t Vertex::*pos>
+class VertexList {
+public:
+	vector<Vertex *> array;
+
+	typedef vector<Vertex *>::const_iterator iterator;
+
+	iterator begin() const { return array.begin(); }
+	iterator end() const { return array.end(); }
+	size_t size() const { return array.size(); }
+	bool empty() const { return array.empty(); }
+	Vertex *front() const { return array.front(); }
+	Vertex *operator[](size_t i) const { return array[i]; }
+
+	void push_back(Vertex *v) {
+		v->*pos = array.size();
+		array.push_back(v);
+	}
+
+	void erase(Vertex *v) {
+		Vertex *last = array.back();
+		array[v->*pos] = last;
+		last->*pos = v->*pos;
+		array.pop_back();
+	}
+
+	template <class It>
+	void assign(It first, It last) {
+		array.clear();
+		for (; first != last; first++)
+			push_back(*first);
+	}
+
+	void clear() {
+		array.clear();
+	}
+};
+
+/* the vertices of G.V by degree, bucket[d] holds the ones of degree d.
+ * vert_change_deg keeps it up to date, and with it restore_snapshot
+ */
+class DegreeBuckets {
+public:
+	vector< vector<Vertex *> > bucket;
+	// the buckets above max_deg are empty, the ones below may be too
+	size_t max_deg = 0;
+	// sum of the degrees, twice the number of edges between vertices of G.V
+	size_t deg_sum = 0;
+
+	void insert(Vertex *v) {
+		if (v->deg >= bucket.size())
+			bucket.resize(v->deg + 1);
+		v->bucket_pos = bucket[v->deg].size();
+		bucket[v->deg].push_back(v);
+		if (v->deg > max_deg)
+			max_deg = v->deg;
+		deg_sum += v->deg;
+	}
+
+	void erase(Vertex *v) {
+		vector<Vertex *> &b = bucket[v->deg];
+		b[v->bucket_pos] = b.back();
+		b[v->bucket_pos]->bucket_pos = v->bucket_pos;
+		b.pop_back();
+		deg_sum -= v->deg;
+	}
+
+	// a vertex of the highest degree, there must be one
+	Vertex *max() {
+		while (bucket[max_deg].empty())
+			max_deg--;
+		return bucket[max_deg].back();
+	}
+
+	void clear() {
+		for (auto &b: bucket)
+			b.clear();
+		max_deg = 0;
+		deg_sum = 0;
+	}
+};
+
+// a fake vertex marking an unmatched vertex, its id is (size_t) -1
+extern Vertex NIL;
+
+/* stuff for Hopcroft-Karp and the LP reduction, see Graph::lp */
+struct lp_data {
+	Vertex *hk_pair[2] = {&NIL, &NIL};
+	size_t hk_dist;      // left vertex
+	bool hk_alternating; // right vertex
+	bool bp_vc[2] = {false, false};
+};
+
 class VertexCover {
 public:
 	vector<Vertex *> V;
@@ -182,29 +268,70 @@ struct vertex_cmp {
 class Graph {
 public:
 	// V does not contain degree 0 vertices
-	list<Vertex *> V;
+	VertexList<&Vertex::pos_V> V;
 	list<Edge *> E;
 
+	// the graph as CSR, built by the parser and again from the kernel once
+	// the reductions before the search are done. The vertices with an id
+	// below core.n are in it, the ones the rules create later aren't. See
+	// for_each_neighbour
+	CSRGraph core;
+
 #if 1
 	// stuff for cycle bound
 	size_t cnt;
 #endif
 
-	// list of degree 1 vertices
-	list<Vertex *> deg1s;
-	// list of degree 2 vertices
-	list<Vertex *> deg2s;
-	// list of degree 3 vertices
-	list<Vertex *> deg3s;
-
+	// the degree 1, 2 and 3 vertices, a vertex is in one of them at most
+	// so they share pos_deg
+	VertexList<&Vertex::pos_deg> deg1s;
+	VertexList<&Vertex::pos_deg> deg2s;
+	VertexList<&Vertex::pos_deg> deg3s;
+	// G.V by degree
+	DegreeBuckets buckets;
+
+	// for inputs with dense integer labels 1..n the label is the name and
+	// label_map[label] is the vertex. Otherwise the name is labels[label - 1]
+	// and name_map is used to look up vertices
+	vector<Vertex *> label_map;
+	vector<string> labels;
 	map<string, Vertex *> name_map;
 
 	size_t recursive_steps = 0;
+	// depth of the current node of the search tree, see stats_node
+	size_t depth = 0;
+
+	// size of the cover outside of this graph, nonzero for the copies solved
+	// by other threads and while solving components. See vc_upper_bound
+	long long offset = 0;
+	// > 0 while solving a component, covers found then are only partial
+	size_t split_depth = 0;
+	// set for the copies of components solved in parallel, offset plus the
+	// cover of this graph must stay below *limit
+	atomic<long long> *limit = nullptr;
 	size_t n  = 0;
 	size_t m  = 0;
 
 	VertexCover VC;
-	vector<GraphModification *> changes;
+	// undo trail, see trail_entry
+	vector<trail_entry> trail;
+	// number of trail entries undone by restore_snapshot
+	size_t trail_undone = 0;
+
+	// memory for vertices, edges and graph modifications
+	Arena arena;
+
+	// number of snapshots not restored yet, and whether one is being restored
+	size_t snapshots = 0;
+	bool undoing = false;
+
+	// vertices whose neighbourhood changed since rule r last looked at them,
+	// it only has to look at those and their neighbours again. Kept once
+	// bit r of dirty_active is set, by the first run of the rule
+	vector<Vertex *> dirty[NUM_DIRTY];
+	uint8_t dirty_active = 0;
+	// the queues taken by rule r inside a snapshot, for TRAIL_DIRTY_TAKE
+	vector< vector<Vertex *> > dirty_taken[NUM_DIRTY];
 
 	// stuff for constraints
 	vector<Constraint *> constraints;
@@ -212,9 +339,18 @@ public:
 
 #if 1
 	/* stuff for Hopcroft-Karp */
-	size_t matching;
+	size_t matching = 0;
+	// per vertex data, lp[v->id + 1] belongs to v and lp[0] to NIL
+	// allocated by the first lp_bound
+	vector<lp_data> lp;
 #endif
 
+	string vertex_name(const Vertex *v) const {
+		if (labels.empty())
+			return to_string(v->label);
+		return labels[v->label - 1];
+	}
+
 	void print() {
 		cout << "# Printing Graph" << endl;
 		for (Vertex *v: this->V) {
@@ -223,16 +359,61 @@ public:
 				if (v->id > b->id)
 					continue;
 
-				cout << "# " << v->name << " " << b->name << endl;
+				cout << "# " << vertex_name(v) << " " << vertex_name(b) << endl;
 			}
 		}
 		cout << "# Printing done" << endl;
 	}
 };
 
+/* true if the neighbours of v are the alive vertices of its row in G.core,
+ * so they can be read from there. Vertices created by the rules have no row,
+ * the ones that got an edge added or moved use Vertex::edges again
+ */
+static inline bool core_clean(const Graph &G, const Vertex *v) {
+	return v->id < G.core.n && G.core.clean[v->id];
+}
+
+// call f on every neighbour of v
+template <class F>
+static inline void for_each_neighbour(const Graph &G, const Vertex *v, F f) {
+	if (core_clean(G, v)) {
+		const CSRGraph &C = G.core;
+		for (const uint32_t *w = C.begin(v->id); w != C.end(v->id); w++) {
+			if (C.alive[*w])
+				f(C.vertex[*w]);
+		}
+	}
+	else {
+		for (auto &edge: v->edges)
+			f(edge.first);
+	}
+}
+
+/* the neighbours of v by position, for loops that have to come back to one
+ * slot i is a neighbour, or nullptr for a vertex of the row that is gone.
+ * The slots stay the same as long as the graph doesn't change
+ */
+static inline size_t nb_slots(const Graph &G, const Vertex *v) {
+	if (core_clean(G, v))
+		return G.core.offset[v->id + 1] - G.core.offset[v->id];
+	return v->edges.size();
+}
+
+static inline Vertex *nb_slot(const Graph &G, const Vertex *v, size_t i) {
+	if (core_clean(G, v)) {
+		uint32_t w = G.core.adj[G.core.offset[v->id] + i];
+		return G.core.alive[w] ? G.core.vertex[w] : nullptr;
+	}
+	return v->edges[i].first;
+}
+
 void vertex_cover(Graph &G, string td, size_t n);
 pair<bool, long long> vc_branch(Graph &G, long long k);
 
+void graph_init_lists(Graph &G);
+vector<Vertex *> graph_copy(Graph &dst, Graph &src, vector<Vertex *> &origin);
+
 /* global variables */
 // a fake vertex that's not in the graph, has id 0 and degree 1
 extern Vertex deg1_vertex;
@@ -0,0 +1,228 @@
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <random>
+#include <chrono>
+#include <limits>
+#include <cassert>
+
+#include "graph.h"
+#include "csr.h"
+#include "read_vc.h"
+#include "time.h"
+#include "local_search.h"
+#include "heuristic.h"
+
+double HEURISTIC_TIME     = 1.0;
+size_t HEURISTIC_ROUNDS   = 100;
+size_t HEURISTIC_LS_STEPS = 100000;
+
+#define HEURISTIC_NONE numeric_limits<uint32_t>::max()
+
+// vertices bucketed by their number of uncovered edges
+struct degree_buckets {
+	vector<uint32_t> head;
+	vector<uint32_t> next;
+	vector<uint32_t> prev;
+	vector<uint32_t> deg;
+
+	// an upper bound of the largest non-empty bucket
+	uint32_t max = 0;
+
+	void insert(uint32_t v) {
+		uint32_t d = deg[v];
+		prev[v] = HEURISTIC_NONE;
+		next[v] = head[d];
+		if (head[d] != HEURISTIC_NONE)
+			prev[head[d]] = v;
+		head[d] = v;
+		if (d > max)
+			max = d;
+	}
+
+	void remove(uint32_t v) {
+		if (prev[v] != HEURISTIC_NONE)
+			next[prev[v]] = next[v];
+		else
+			head[deg[v]] = next[v];
+		if (next[v] != HEURISTIC_NONE)
+			prev[next[v]] = prev[v];
+	}
+};
+
+/* greedy cover: take the neighbour of a degree 1 vertex if there is one,
+ * otherwise a vertex of maximum degree. The order of the vertices breaks ties
+ */
+static void greedy_cover(const CSRGraph &C, const vector<uint32_t> &order, vector<uint8_t> &cover) {
+	static thread_local degree_buckets B;
+	static thread_local vector<uint8_t> done;
+
+	uint32_t max_deg = 0;
+	for (uint32_t v = 0; v < C.n; v++)
+		max_deg = std::max(max_deg, C.deg[v]);
+
+	// there's always a bucket for degree 1
+	B.head.assign(max_deg + 2, HEURISTIC_NONE);
+	B.next.resize(C.n);
+	B.prev.resize(C.n);
+	B.deg.assign(C.deg.begin(), C.deg.end());
+	B.max = 0;
+
+	cover.assign(C.n, 0);
+	done.assign(C.n, 0);
+
+	for (uint32_t v: order) {
+		if (B.deg[v] == 0)
+			done[v] = 1;
+		else
+			B.insert(v);
+	}
+
+	while (true) {
+		uint32_t v;
+
+		if (B.head[1] != HEURISTIC_NONE) {
+			// the only uncovered edge of a degree 1 vertex is covered by its neighbour
+			uint32_t a = B.head[1];
+			v = HEURISTIC_NONE;
+			for (const uint32_t *u = C.begin(a); u != C.end(a); u++) {
+				if (!done[*u]) {
+					v = *u;
+					break;
+				}
+			}
+			assert(v != HEURISTIC_NONE);
+		}
+		else {
+			while (B.max > 0 && B.head[B.max] == HEURISTIC_NONE)
+				B.max--;
+			if (B.max == 0)
+				break;
+			v = B.head[B.max];
+		}
+
+		cover[v] = 1;
+		done[v] = 1;
+		B.remove(v);
+
+		for (const uint32_t *u = C.begin(v); u != C.end(v); u++) {
+			if (done[*u])
+				continue;
+
+			B.remove(*u);
+			B.deg[*u]--;
+			if (B.deg[*u] == 0)
+				done[*u] = 1;
+			else
+				B.insert(*u);
+		}
+	}
+}
+
+// drop the vertices whose neighbours are all in the cover
+static size_t prune_cover(const CSRGraph &C, vector<uint8_t> &cover) {
+	size_t size = 0;
+
+	for (uint32_t v = 0; v < C.n; v++) {
+		if (!cover[v])
+			continue;
+
+		bool redundant = true;
+		for (const uint32_t *u = C.begin(v); u != C.end(v); u++) {
+			if (!cover[*u]) {
+				redundant = false;
+				break;
+			}
+		}
+
+		if (redundant)
+			cover[v] = 0;
+		else
+			size++;
+	}
+
+	return size;
+}
+
+size_t vc_greedy(const CSRGraph &C, vector<uint8_t> &cover, chrono::steady_clock::time_point deadline) {
+	vector<uint32_t> order(C.n);
+	for (uint32_t i = 0; i < C.n; i++)
+		order[i] = i;
+
+	vector<uint8_t> best;
+	size_t best_size = C.n + 1;
+	size_t fails = 0;
+
+	// the same seed every time, so runs can be reproduced
+	mt19937 rng(C.n);
+
+	while (true) {
+		greedy_cover(C, order, cover);
+		size_t size = prune_cover(C, cover);
+
+		if (size < best_size) {
+			best_size = size;
+			best.swap(cover);
+			fails = 0;
+		}
+		else {
+			fails++;
+		}
+
+		if (fails >= HEURISTIC_ROUNDS || TIME_stop || chrono::steady_clock::now() >= deadline)
+			break;
+
+		// restart with different ties
+		shuffle(order.begin(), order.end(), rng);
+	}
+
+	cover.swap(best);
+	return best_size;
+}
+
+void vc_lift_cover(Graph &G, const CSRGraph &C, const vector<uint8_t> &cover, list<Vertex *> &sol) {
+	for (uint32_t i = 0; i < C.n; i++) {
+		if (cover[i])
+			rvc_add_vertex(C.vertex[i], sol);
+	}
+	read_vc(G, sol);
+	for (Vertex *a: sol)
+		a->in_vc = false;
+}
+
+size_t vc_heuristic(Graph &G, list<Vertex *> &sol) {
+	auto start = chrono::steady_clock::now();
+	auto deadline = chrono::time_point_cast<chrono::steady_clock::duration>(
+		min(start + chrono::duration<double>(HEURISTIC_TIME),
+		    TIME_start + chrono::duration<double>(TIMEOUT)));
+
+	// leave the rest of the time limit to the output
+	if (TIME_LIMIT > 0)
+		deadline = min(deadline, chrono::time_point_cast<chrono::steady_clock::duration>(
+			TIME_start + chrono::duration<double>(TIME_LIMIT)));
+
+	CSRGraph C;
+	csr_build(C, G);
+
+	vector<uint8_t> cover;
+	size_t greedy_size = vc_greedy(C, cover, deadline);
+
+	// improve it with a local search for the rest of the time
+	ls_limits limits;
+	limits.deadline = deadline;
+	limits.max_idle = HEURISTIC_LS_STEPS;
+	size_t size = ls_numvc(C, cover, limits);
+
+	sol.clear();
+	vc_lift_cover(G, C, cover, sol);
+
+	double secs = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+	auto flags = cout.flags();
+	auto prec  = cout.precision();
+	cout << fixed << setprecision(2);
+	cout << "c heuristic: " << sol.size() << " (kernel " << greedy_size << " greedy, " << size << " local search) in " << secs << " s" << endl;
+	cout.flags(flags);
+	cout.precision(prec);
+
+	return size;
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <list>
+#include <vector>
+#include <chrono>
+
+#include "graph.h"
+#include "csr.h"
+using namespace std;
+
+/* find a small vertex cover of the kernel G.V, lifted to the original graph
+ * with read_vc. It's used as the first upper bound of the exact search, so
+ * the branch and bound can prune from the start. Returns the size of the
+ * cover of the kernel
+ */
+size_t vc_heuristic(Graph &G, list<Vertex *> &sol);
+
+/* greedy vertex cover of C, restarted with different ties until
+ * HEURISTIC_ROUNDS restarts didn't help, the deadline passed or TIME_stop
+ * was set. Returns the size of the cover, there is one after the first try
+ */
+size_t vc_greedy(const CSRGraph &C, vector<uint8_t> &cover, chrono::steady_clock::time_point deadline);
+
+// add the cover of the kernel to sol and translate it to the original graph
+void vc_lift_cover(Graph &G, const CSRGraph &C, const vector<uint8_t> &cover, list<Vertex *> &sol);
+
+
+/* configurables */
+// seconds spent on improving the first cover, capped by TIMEOUT and
+// TIME_LIMIT
+extern double HEURISTIC_TIME;
+// stop after this many restarts in a row did not find a smaller cover
+extern size_t HEURISTIC_ROUNDS;
+// stop the local search after this many steps without a smaller cover
+extern size_t HEURISTIC_LS_STEPS;
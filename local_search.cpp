@@ -0,0 +1,358 @@
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <random>
+#include <limits>
+#include <cassert>
+
+#include "graph.h"
+#include "csr.h"
+#include "optimize.h"
+#include "stats.h"
+#include "heuristic.h"
+#include "time.h"
+#include "local_search.h"
+
+bool   CONFIG_LOCAL_SEARCH = false;
+double LS_TIME             = TIMEOUT;
+size_t LS_TARGET           = 0;
+size_t LS_SAMPLES          = 50;
+
+// weights are scaled down by LS_FORGET once their average exceeds n * LS_GAMMA
+#define LS_GAMMA  0.5
+#define LS_FORGET 0.3
+
+#define LS_NONE numeric_limits<uint32_t>::max()
+
+// a set of ids with O(1) insert, remove and random access
+struct ls_set {
+	vector<uint32_t> items;
+	vector<uint32_t> pos;
+
+	void init(size_t n) {
+		items.clear();
+		pos.assign(n, LS_NONE);
+	}
+
+	void insert(uint32_t x) {
+		pos[x] = items.size();
+		items.push_back(x);
+	}
+
+	void remove(uint32_t x) {
+		uint32_t last = items.back();
+		items[pos[x]] = last;
+		pos[last] = pos[x];
+		items.pop_back();
+		pos[x] = LS_NONE;
+	}
+};
+
+struct ls_state {
+	uint32_t n;
+	size_t m;
+
+	// the adjacency of C with the id of each edge next to it
+	const CSRGraph &C;
+	vector<uint32_t> eid;
+	vector<uint32_t> edge_a;
+	vector<uint32_t> edge_b;
+
+	vector<uint64_t> weight;
+	uint64_t total_weight = 0;
+
+	// the change of the uncovered weight when v is added or removed
+	vector<int64_t> dscore;
+	// the step v was last added or removed in
+	vector<uint64_t> age;
+	// configuration checking: v may only be added if this is set
+	vector<uint8_t> conf;
+
+	vector<uint8_t> in_cover;
+	ls_set cover;
+	ls_set uncovered;
+
+	mt19937 rng;
+
+	ls_state(const CSRGraph &C) : n(C.n), m(C.m), C(C), rng(C.n) {};
+
+	void add(uint32_t v);
+	void remove(uint32_t v);
+	void compute_dscores();
+	void forget();
+};
+
+void ls_state::add(uint32_t v) {
+	in_cover[v] = 1;
+	cover.insert(v);
+	dscore[v] = -dscore[v];
+
+	for (size_t i = C.offset[v]; i < C.offset[v + 1]; i++) {
+		uint32_t u = C.adj[i];
+		uint32_t e = eid[i];
+
+		if (in_cover[u]) {
+			// u doesn't cover e on its own anymore
+			dscore[u] += weight[e];
+		}
+		else {
+			dscore[u] -= weight[e];
+			uncovered.remove(e);
+		}
+	}
+}
+
+void ls_state::remove(uint32_t v) {
+	in_cover[v] = 0;
+	cover.remove(v);
+	dscore[v] = -dscore[v];
+
+	for (size_t i = C.offset[v]; i < C.offset[v + 1]; i++) {
+		uint32_t u = C.adj[i];
+		uint32_t e = eid[i];
+
+		if (in_cover[u]) {
+			dscore[u] -= weight[e];
+		}
+		else {
+			dscore[u] += weight[e];
+			uncovered.insert(e);
+		}
+	}
+}
+
+void ls_state::compute_dscores() {
+	dscore.assign(n, 0);
+
+	for (size_t e = 0; e < m; e++) {
+		uint32_t a = edge_a[e];
+		uint32_t b = edge_b[e];
+
+		if (in_cover[a] && !in_cover[b])
+			dscore[a] -= weight[e];
+		else if (in_cover[b] && !in_cover[a])
+			dscore[b] -= weight[e];
+		else if (!in_cover[a] && !in_cover[b]) {
+			dscore[a] += weight[e];
+			dscore[b] += weight[e];
+		}
+	}
+}
+
+void ls_state::forget() {
+	total_weight = 0;
+	for (size_t e = 0; e < m; e++) {
+		weight[e] = max<uint64_t>(1, weight[e] * LS_FORGET);
+		total_weight += weight[e];
+	}
+
+	compute_dscores();
+}
+
+// number the edges, both directions of an edge get the same id
+static void ls_number_edges(ls_state &S) {
+	const CSRGraph &C = S.C;
+
+	S.eid.assign(C.adj.size(), LS_NONE);
+	S.edge_a.clear();
+	S.edge_b.clear();
+
+	// edges a-b with a < b, numbered from the side of a
+	vector<size_t> first(S.n + 1, 0);
+	for (uint32_t a = 0; a < S.n; a++) {
+		for (size_t i = C.offset[a]; i < C.offset[a + 1]; i++) {
+			uint32_t b = C.adj[i];
+			if (b < a)
+				continue;
+
+			S.eid[i] = S.edge_a.size();
+			S.edge_a.push_back(a);
+			S.edge_b.push_back(b);
+			first[b + 1]++;
+		}
+	}
+
+	// group them by b, then look them up from the side of b
+	for (uint32_t b = 0; b < S.n; b++)
+		first[b + 1] += first[b];
+
+	vector<uint32_t> by_b(S.edge_a.size());
+	vector<size_t> pos(first.begin(), first.end() - 1);
+	for (uint32_t e = 0; e < S.edge_a.size(); e++)
+		by_b[pos[S.edge_b[e]]++] = e;
+
+	vector<uint32_t> edge_to(S.n);
+	for (uint32_t b = 0; b < S.n; b++) {
+		for (size_t j = first[b]; j < first[b + 1]; j++)
+			edge_to[S.edge_a[by_b[j]]] = by_b[j];
+
+		for (size_t i = C.offset[b]; i < C.offset[b + 1]; i++) {
+			if (C.adj[i] < b)
+				S.eid[i] = edge_to[C.adj[i]];
+		}
+	}
+
+	assert(S.edge_a.size() == S.m);
+}
+
+// is a a better choice than b, by dscore and then by age
+static inline bool ls_better(ls_state &S, uint32_t a, uint32_t b) {
+	if (S.dscore[a] != S.dscore[b])
+		return S.dscore[a] > S.dscore[b];
+	return S.age[a] < S.age[b];
+}
+
+size_t ls_numvc(const CSRGraph &C, vector<uint8_t> &cover, const ls_limits &limits) {
+	ls_state S(C);
+	ls_number_edges(S);
+
+	S.weight.assign(S.m, 1);
+	S.total_weight = S.m;
+	S.age.assign(S.n, 0);
+	S.conf.assign(S.n, 1);
+	S.in_cover.assign(cover.begin(), cover.end());
+	S.cover.init(S.n);
+	S.uncovered.init(S.m);
+
+	for (uint32_t v = 0; v < S.n; v++) {
+		if (S.in_cover[v])
+			S.cover.insert(v);
+	}
+	S.compute_dscores();
+
+	size_t best = S.cover.items.size();
+	uint64_t last_improvement = 0;
+	uint32_t tabu = LS_NONE;
+
+	for (uint64_t step = 1; ; step++) {
+		// a cover: remember it and try one vertex less
+		while (S.uncovered.items.empty()) {
+			size_t size = S.cover.items.size();
+			if (size < best || step == 1) {
+				if (size < best && limits.verbose) {
+					double secs = chrono::duration<double>(chrono::steady_clock::now() - TIME_start).count();
+					auto flags = cout.flags();
+					auto prec  = cout.precision();
+					cout << fixed << setprecision(3);
+					cout << "c ls: " << size + limits.offset << " after " << secs << " s" << endl;
+					cout.flags(flags);
+					cout.precision(prec);
+				}
+
+				best = size;
+				last_improvement = step;
+				for (uint32_t v = 0; v < S.n; v++)
+					cover[v] = S.in_cover[v];
+			}
+
+			if (size <= limits.target || size == 0)
+				return best;
+
+			uint32_t v = S.cover.items[0];
+			for (uint32_t u: S.cover.items) {
+				if (ls_better(S, u, v))
+					v = u;
+			}
+			S.remove(v);
+			S.age[v] = step;
+		}
+
+		if ((step & 1023) == 0 && (TIME_stop.load(memory_order_relaxed) || chrono::steady_clock::now() >= limits.deadline))
+			break;
+		if (limits.max_idle > 0 && step - last_improvement > limits.max_idle)
+			break;
+
+		// remove the best of a few vertices of the cover (BMS, as in FastVC).
+		// The dscores move by edge weights every step and forget rescales
+		// them, so they don't fit into buckets of a small range
+		uint32_t v = LS_NONE;
+		size_t size = S.cover.items.size();
+		size_t samples = min(LS_SAMPLES, size);
+		for (size_t i = 0; i < samples; i++) {
+			uint32_t u = samples == size ? S.cover.items[i] : S.cover.items[S.rng() % size];
+			if (u == tabu)
+				continue;
+			if (v == LS_NONE || ls_better(S, u, v))
+				v = u;
+		}
+
+		if (v != LS_NONE) {
+			S.remove(v);
+			S.age[v] = step;
+			S.conf[v] = 0;
+			for (const uint32_t *u = C.begin(v); u != C.end(v); u++)
+				S.conf[*u] = 1;
+		}
+
+		// cover a random uncovered edge by one of its endpoints
+		uint32_t e = S.uncovered.items[S.rng() % S.uncovered.items.size()];
+		uint32_t a = S.edge_a[e];
+		uint32_t b = S.edge_b[e];
+
+		uint32_t w;
+		if (!S.conf[a])
+			w = b;
+		else if (!S.conf[b])
+			w = a;
+		else
+			w = ls_better(S, a, b) ? a : b;
+
+		S.add(w);
+		S.age[w] = step;
+		tabu = w;
+		for (const uint32_t *u = C.begin(w); u != C.end(w); u++)
+			S.conf[*u] = 1;
+
+		// make the edges that stay uncovered more important
+		for (uint32_t f: S.uncovered.items) {
+			S.weight[f]++;
+			S.dscore[S.edge_a[f]]++;
+			S.dscore[S.edge_b[f]]++;
+		}
+		S.total_weight += S.uncovered.items.size();
+
+		if (S.total_weight > LS_GAMMA * S.n * S.m)
+			S.forget();
+	}
+
+	return best;
+}
+
+void vertex_cover_ls(Graph &G, size_t n) {
+	long long k = 0;
+
+	vc_preoptimize(G, k);
+	print_graph_optimization(G);
+
+	CSRGraph C;
+	csr_build(C, G);
+
+	// the greedy cover is the starting point
+	vector<uint8_t> cover;
+	size_t size = vc_greedy(C, cover, chrono::steady_clock::now());
+
+	// the number of vertices the reductions add to a cover of the kernel
+	list<Vertex *> sol;
+	vc_lift_cover(G, C, cover, sol);
+	size_t offset = sol.size() - size;
+	cout << "c ls: " << sol.size() << " after greedy" << endl;
+
+	ls_limits limits;
+	limits.deadline = TIME_start + chrono::duration_cast<chrono::steady_clock::duration>(chrono::duration<double>(LS_TIME));
+	limits.target   = LS_TARGET > offset ? LS_TARGET - offset : 0;
+	limits.verbose  = true;
+	limits.offset   = offset;
+
+	ls_numvc(C, cover, limits);
+
+	sol.clear();
+	vc_lift_cover(G, C, cover, sol);
+
+	cout << "c VC size = " << sol.size() << endl;
+	cout << "s vc " << n << " " << sol.size() << endl;
+
+	for (Vertex *v: sol) {
+		assert(v->downcast == nullptr);
+		cout << G.vertex_name(v) << endl;
+	}
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "graph.h"
+#include "csr.h"
+using namespace std;
+
+// when ls_numvc stops
+struct ls_limits {
+	chrono::steady_clock::time_point deadline;
+	// stop once the cover has at most this many vertices
+	size_t target = 0;
+	// stop after this many steps without a smaller cover, 0 for never
+	size_t max_idle = 0;
+	// print every smaller cover (its size plus offset) with the time since TIME_start
+	bool verbose = false;
+	size_t offset = 0;
+};
+
+/* NuMVC local search: edge weighting with forgetting and configuration
+ * checking, the vertex to remove is picked from a sample of the cover
+ * (best from multiple selection, as in FastVC) so each step is O(deg).
+ *
+ * cover has to be a vertex cover of C, it's replaced by the smallest one
+ * found. Returns its size
+ */
+size_t ls_numvc(const CSRGraph &C, vector<uint8_t> &cover, const ls_limits &limits);
+
+// anytime solver: local search on the kernel until LS_TIME or LS_TARGET
+void vertex_cover_ls(Graph &G, size_t n);
+
+
+/* configurables */
+// run vertex_cover_ls instead of the exact search
+extern bool CONFIG_LOCAL_SEARCH;
+// seconds since the start of the program vertex_cover_ls stops at
+extern double LS_TIME;
+// vertex_cover_ls stops at a cover of this size, 0 for none
+extern size_t LS_TARGET;
+// vertices sampled when picking the vertex to remove
+extern size_t LS_SAMPLES;
@@ -30,6 +30,7 @@ void steal_edge(Graph &G, Edge *e, Vertex *from, Vertex *to, Vertex *neigh) {
 
 	// update neighbour
 	neigh->edges[e->pos[1]].first = to;
+	core_touch(G, neigh);
 }
 
 
@@ -56,11 +57,12 @@ void delete_edge(Graph &G, Edge *e, Vertex *a, Vertex *to, Vertex *b) {
 	G.E.erase(e->iterE);
 	e->iterE = empty_iterator2;
 
+	core_touch(G, b);
 	vert_change_deg(G, b, b->deg - 1);
 }
 
 MergedVertex::MergedVertex(Graph &G, size_t id, Vertex *u, Vertex *v, Vertex *w)
-: Vertex(id, u->name + "+" + v->name + "+" + w->name), G(G) {
+: Vertex(id, NO_LABEL), G(G) {
 	assert(v->deg == 2);
 	assert(u->merge == nullptr && v->merge == nullptr && w->merge == nullptr);
 	v->merge = this;
@@ -138,8 +140,7 @@ MergedVertex::MergedVertex(Graph &G, size_t id, Vertex *u, Vertex *v, Vertex *w)
 	vert_mark_uncertain(G, w);
 
 	// register this graph transformation
-	GM_Vertex_Merge *op = new GM_Vertex_Merge(this);
-	G.changes.push_back(op);
+	trail_push(G, TRAIL_VERTEX_MERGE, this);
 }
 
 
@@ -234,12 +235,9 @@ MergedVertex::~MergedVertex() {
 	assert(this->G.n == id);
 }
 
-void GM_Vertex_Merge::undo(Graph &G) {
-	delete this->m;
-}
-
-void GM_Vertex_Merge::translate_vc(Graph &G, list<Vertex *> &sol) {
-	MergedVertex *m = this->m;
+// undoing the merge is done by the destructor
+void MergedVertex::translate_vc(list<Vertex *> &sol) {
+	MergedVertex *m = this;
 	assert(!m->v->in_vc && !m->u->in_vc && !m->w->in_vc);
 
 	if (m->in_vc) {
@@ -17,17 +17,10 @@ public:
 
 	MergedVertex(Graph &G, size_t id, Vertex *a, Vertex *b, Vertex *c);
 	~MergedVertex();
+
+	void translate_vc(list<Vertex *> &sol);
 	
 private:
 	Graph &G;
 };
 
-
-class GM_Vertex_Merge : public GraphModification {
-public:
-	virtual void undo(Graph &G);
-	virtual void translate_vc(Graph &G, list<Vertex *> &sol);
-	GM_Vertex_Merge(MergedVertex *v) : m(v) {};
-
-	MergedVertex *m;
-};
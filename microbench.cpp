@@ -0,0 +1,198 @@
+// Microbenchmarks of single reduction rules and bounds: loads a graph once
+// and times every kernel on its own, restoring a snapshot after each call
+// so all of them see the same graph.
+//
+// Usage: microbench [-i iterations] [-s sample] [-p] [-k kernel,...]
+//                   [config.conf] < graph.gr
+//   -p  run vc_preoptimize first and measure on the kernel
+//   -s  the per vertex kernels run on this many vertices of G.V
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <set>
+#include <chrono>
+#include <functional>
+
+#include <unistd.h>
+
+#include "graph.h"
+#include "parse.h"
+#include "config.h"
+#include "time.h"
+#include "snapshot.h"
+#include "optimize.h"
+#include "deg3.h"
+#include "clique_neigh.h"
+#include "bipart.h"
+#include "clique.h"
+#include "mirror.h"
+
+using namespace std;
+
+struct kernel {
+	const char *name;
+	// runs on every vertex of the sample instead of once on the graph
+	bool per_vertex;
+	// leaves the graph as it was, no snapshot needed
+	bool read_only;
+	// returns whether the kernel changed the graph, or for unconfined
+	// whether v is
+	function<bool(Graph &, Vertex *)> run;
+};
+
+struct kernel_result {
+	size_t calls = 0;
+	size_t changed = 0;
+	double ns = 0;
+};
+
+static double run_once(Graph &G, const kernel &K, Vertex *v, bool &changed) {
+	graph_snapshot s;
+	if (!K.read_only)
+		s = create_snapshot(G);
+
+	auto start = chrono::steady_clock::now();
+	changed = K.run(G, v);
+	double ns = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count();
+
+	if (!K.read_only)
+		restore_snapshot(G, s);
+	return ns;
+}
+
+// the first round is a warm up and not counted
+static kernel_result bench_kernel(Graph &G, const kernel &K, const vector<Vertex *> &sample, size_t iters) {
+	kernel_result r;
+	for (size_t i = 0; i <= iters; i++) {
+		if (K.per_vertex) {
+			for (Vertex *v: sample) {
+				bool changed;
+				double ns = run_once(G, K, v, changed);
+				if (i == 0)
+					continue;
+				r.calls++;
+				r.changed += changed;
+				r.ns += ns;
+			}
+		}
+		else {
+			bool changed;
+			double ns = run_once(G, K, nullptr, changed);
+			if (i == 0)
+				continue;
+			r.calls++;
+			r.changed += changed;
+			r.ns += ns;
+		}
+	}
+	return r;
+}
+
+static void usage(const char *argv0) {
+	cerr << "Usage: " << argv0 << " [-i iterations] [-s sample] [-p] [-k kernel,...] [config.conf] < graph.gr" << endl;
+	exit(2);
+}
+
+int main(int argc, char **argv) {
+	TIME_start = chrono::steady_clock::now();
+
+	size_t iters = 10;
+	size_t sample_size = 1000;
+	bool preoptimize = false;
+	set<string> only;
+
+	int opt;
+	while ((opt = getopt(argc, argv, "i:s:pk:")) != -1) {
+		switch (opt) {
+		case 'i': iters = stoull(optarg); break;
+		case 's': sample_size = stoull(optarg); break;
+		case 'p': preoptimize = true; break;
+		case 'k': {
+			istringstream in(optarg);
+			string name;
+			while (getline(in, name, ','))
+				only.insert(name);
+			break;
+		}
+		default: usage(argv[0]);
+		}
+	}
+	if (argc - optind > 1 || iters == 0)
+		usage(argv[0]);
+	if (argc - optind == 1)
+		read_config_from_file(argv[optind]);
+
+	std::ios::sync_with_stdio(false);
+
+	Graph G;
+	string td;
+	size_t n = 0;
+	if (!parse_graph(G, STDIN_FILENO, td, n)) {
+		cout << "Parsing error\n";
+		return 1;
+	}
+	graph_init_lists(G);
+
+	long long k = 0;
+	if (preoptimize) {
+		vc_preoptimize(G, k);
+		// like vertex_cover_v2 the rules see the kernel as G.core
+		csr_build_core(G);
+	}
+
+	cout << "c nodes: " << G.V.size() << endl;
+	cout << "c edges: " << G.E.size() << endl;
+
+	// every (n / sample_size)-th vertex, the same ones every run
+	vector<Vertex *> sample;
+	size_t step = max<size_t>(1, G.V.size() / max<size_t>(1, sample_size));
+	size_t i = 0;
+	for (Vertex *v: G.V) {
+		if (i++ % step == 0 && sample.size() < sample_size)
+			sample.push_back(v);
+	}
+
+	// the rules get a copy of k, they must not see each other's changes
+	vector<kernel> kernels = {
+		{"deg1", false, false, [](Graph &G, Vertex *) { return vc_deg1_rule(G); }},
+		{"deg2", false, false, [k](Graph &G, Vertex *) { long long k2 = k; return vc_deg2_rule(G, k2); }},
+		{"domination", false, false, [](Graph &G, Vertex *) { return vc_domination_rule(G); }},
+		{"deg3", false, false, [k](Graph &G, Vertex *) { long long k2 = k; return vc_deg3_rule(G, k2); }},
+		{"unconfined", true, true, [](Graph &G, Vertex *v) { return vertex_unconfined(G, v); }},
+		{"clique_neigh", true, false, [k](Graph &G, Vertex *v) { long long k2 = k; return vc_clique_neigh_single(G, v, k2); }},
+		{"mirrors", true, false, [](Graph &G, Vertex *v) {
+			size_t vc = G.VC.V.size();
+			add_mirrors_to_vc(G, v);
+			return G.VC.V.size() != vc;
+		}},
+		{"lp_bound", false, false, [](Graph &G, Vertex *) {
+			size_t vc = G.VC.V.size();
+			lp_bound(G);
+			return G.VC.V.size() != vc;
+		}},
+		{"clique_bound", false, false, [](Graph &G, Vertex *) { clique_bound(G); return false; }},
+		// taking v and undoing it, the cost of a branch without the search
+		{"snapshot", true, true, [](Graph &G, Vertex *v) {
+			graph_snapshot s = create_snapshot(G);
+			add_to_vc(G, v);
+			restore_snapshot(G, s);
+			return false;
+		}},
+	};
+
+	auto flags = cout.flags();
+	cout << fixed << setprecision(3);
+	for (const kernel &K: kernels) {
+		if (!only.empty() && !only.count(K.name))
+			continue;
+
+		kernel_result r = bench_kernel(G, K, sample, iters);
+		cout << "c kernel " << K.name << ": calls " << r.calls << ", changed " << r.changed
+		     << ", " << r.ns / 1e6 << " ms, " << (r.calls > 0 ? r.ns / r.calls : 0) << " ns/call" << endl;
+	}
+	cout.flags(flags);
+
+	return 0;
+}
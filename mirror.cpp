@@ -4,6 +4,7 @@
 #include "graph.h"
 #include "mirror.h"
 #include "snapshot.h"
+#include "stats.h"
 
 bool mirror_induces_clique(Vertex *v) {
 	size_t size = 0;
@@ -34,6 +35,7 @@ bool mirror_induces_clique(Vertex *v) {
 }
 
 void add_mirrors_to_vc(Graph &G, Vertex *v) {
+	stat_scope scope(G, STAT_MIRRORS);
 
 	// set of vertices with distance 2 to v
 	unordered_set<Vertex *> D2;
@@ -1,5 +1,8 @@
 #include <cassert>
 #include <algorithm>
+#include <iostream>
+#include <iomanip>
+#include <chrono>
 
 #include "graph.h"
 #include "merge.h"
@@ -9,6 +12,8 @@
 #include "snapshot.h"
 #include "clique_neigh.h"
 #include "undeg3.h"
+#include "stats.h"
+#include "time.h"
 
 
 optimization_rules enabled_rules[NUM_RULES] = {
@@ -34,6 +39,65 @@ optimization_rules enabled_rules[NUM_RULES] = {
 size_t UNCONF_CUTOFF  = 50000;
 size_t UNCONF_MAX_DEG = 5000;
 
+size_t PREOPT_MAX_ROUNDS = 50;
+double PREOPT_MIN_RATE   = 0.001;
+size_t PREOPT_PATIENCE   = 2;
+
+/* the vertices rule r has to look at: the ones in G.dirty[r] and their
+ * neighbours, or all of them the first time the rule runs
+ */
+static void dirty_take(Graph &G, dirty_rule r, vector<Vertex *> &out) {
+	uint8_t bit = 1 << r;
+	out.clear();
+
+	if (!(G.dirty_active & bit)) {
+		G.dirty_active |= bit;
+		out.assign(G.V.begin(), G.V.end());
+		return;
+	}
+
+	for (Vertex *v: G.dirty[r]) {
+		v->dirty &= ~bit;
+
+		if (!v->marked && v->deg > 0) {
+			v->marked = true;
+			out.push_back(v);
+		}
+		for (auto edge: v->edges) {
+			Vertex *u = edge.first;
+			if (!u->marked) {
+				u->marked = true;
+				out.push_back(u);
+			}
+		}
+	}
+
+	// inside a snapshot the queue goes on the trail, restore_snapshot
+	// gives it back
+	if (G.snapshots > 0) {
+		G.dirty_taken[r].emplace_back();
+		G.dirty_taken[r].back().swap(G.dirty[r]);
+		trail_push(G, TRAIL_DIRTY_TAKE, nullptr, (void *) (uintptr_t) r);
+	}
+	G.dirty[r].clear();
+
+	for (Vertex *v: out)
+		v->marked = false;
+}
+
+// put back the vertices of a taken queue that rule r didn't get to
+static void dirty_requeue(Graph &G, dirty_rule r, vector<Vertex *> &todo, size_t from) {
+	uint8_t bit = 1 << r;
+
+	for (size_t i = from; i < todo.size(); i++) {
+		Vertex *v = todo[i];
+		if (v->deg > 0 && !(v->dirty & bit)) {
+			v->dirty |= bit;
+			G.dirty[r].push_back(v);
+		}
+	}
+}
+
 /* if an edge has a vertex with degree 1 select its neighbour */
 bool vc_deg1_rule(Graph &G) {
 	bool rerun;
@@ -47,7 +111,14 @@ bool vc_deg1_rule(Graph &G) {
 			Vertex *v = *G.deg1s.begin();
 			
 			assert(v->edges.size() == 1);
-			Vertex *b = v->edges.begin()->first;
+
+			// a clean row has lost all other neighbours already, paying
+			// for the scan
+			Vertex *b = nullptr;
+			for_each_neighbour(G, v, [&](Vertex *a) {
+				b = a;
+			});
+			assert(b == v->edges[0].first);
 
 			add_to_vc(G, b);
 			rerun = true;
@@ -72,11 +143,19 @@ bool vc_deg2_rule_single(Graph &G, long long &k, Vertex *v) {
 	// check if there's an edge between u and w
 	Vertex *x = u->edges.size() < w->edges.size() ? u : w;
 	Vertex *y = u->edges.size() < w->edges.size() ? w : u;
-	
-	for (it = x->edges.begin(); it != x->edges.end(); it++) {
-		if (it->first == y) {
-			uw_edge = true;
-			break;
+	if (!core_clean(G, x) && core_clean(G, y))
+		swap(x, y);
+
+	if (core_clean(G, x)) {
+		// the row is sorted and y is alive, it's a neighbour if it's in there
+		uw_edge = y->id < G.core.n && binary_search(G.core.begin(x->id), G.core.end(x->id), (uint32_t) y->id);
+	}
+	else {
+		for (it = x->edges.begin(); it != x->edges.end(); it++) {
+			if (it->first == y) {
+				uw_edge = true;
+				break;
+			}
 		}
 	}
 
@@ -86,7 +165,7 @@ bool vc_deg2_rule_single(Graph &G, long long &k, Vertex *v) {
 	}
 	else {
 		// the constructor takes care of registering the transformation
-		MergedVertex *m = new MergedVertex(G, G.n, u, v, w);
+		MergedVertex *m = arena_new<MergedVertex>(G.arena, G, G.n, u, v, w);
 		G.n++;
 		k--;
 	}
@@ -117,15 +196,22 @@ bool vc_deg2_rule(Graph &G, long long &k) {
 	return ran;
 }
 
+// set Vertex::marked, and the mark in G.core that the scans of clean rows read
+static inline void dom_mark(Graph &G, Vertex *v, bool marked) {
+	v->marked = marked;
+	if (v->id < G.core.n)
+		G.core.mark[v->id] = marked;
+}
+
 bool vc_domination_single(Graph &G, Vertex *v) {
 	bool success = false;
 
 	// mark all neighbours
-	v->marked = true;
+	dom_mark(G, v, true);
 	for (size_t i = 0; i < v->edges.size(); i++) {
 		Vertex *u = v->edges[i].first;
 		assert(!u->marked);
-		u->marked = true;
+		dom_mark(G, u, true);
 	}
 
 
@@ -145,20 +231,36 @@ bool vc_domination_single(Graph &G, Vertex *v) {
 		}
 
 		// count how many marked vertices u has
-		for (size_t j = 0; j < u->edges.size(); j++) {
-			Vertex *w = u->edges[j].first;
-			size_t remaining = u->edges.size() - j - 1;
-
-			if (w->marked)
-				count++;
-			if (remaining + count < needed)
-				break;
+		if (core_clean(G, u)) {
+			// only alive vertices are marked, the dead ones of the row
+			// just count as remaining
+			const CSRGraph &C = G.core;
+			const uint32_t *end = C.end(u->id);
+			for (const uint32_t *w = C.begin(u->id); w != end; w++) {
+				size_t remaining = end - w - 1;
+
+				if (C.mark[*w])
+					count++;
+				if (remaining + count < needed)
+					break;
+			}
+		}
+		else {
+			for (size_t j = 0; j < u->edges.size(); j++) {
+				Vertex *w = u->edges[j].first;
+				size_t remaining = u->edges.size() - j - 1;
+
+				if (w->marked)
+					count++;
+				if (remaining + count < needed)
+					break;
+			}
 		}
 
 
 		// if the neighbourhoods are the same, add u to the vertex cover and run the algo again
 		if (count == needed) {
-			u->marked = false;
+			dom_mark(G, u, false);
 			add_to_vc(G, u);
 			success = true;
 		}
@@ -167,11 +269,11 @@ bool vc_domination_single(Graph &G, Vertex *v) {
 		}
 	}
 
-	v->marked = false;
+	dom_mark(G, v, false);
 	for (size_t i = 0; i < v->edges.size(); i++) {
 		Vertex *u = v->edges[i].first;
 		assert(u->marked);
-		u->marked = false;
+		dom_mark(G, u, false);
 	}
 
 	if (success)
@@ -180,21 +282,23 @@ bool vc_domination_single(Graph &G, Vertex *v) {
 }
 
 bool vc_domination_rule(Graph &G) {
-	bool rerun;
 	bool ran = false;
-	do {
-		rerun = false;
-		// iterate over all uncovered nodes
+	vector<Vertex *> todo;
 
-		list<Vertex *> list_V(G.V);
-		for (Vertex* v: list_V) {
-			if (vc_domination_single(G, v)) {
-				rerun = true;
-				ran   = true;
-			}
+	// until no vertex near a change is left
+	while (true) {
+		dirty_take(G, DIRTY_DOM, todo);
+		if (todo.empty())
+			break;
+
+		for (Vertex* v: todo) {
+			if (v->deg == 0)
+				continue;
+
+			if (vc_domination_single(G, v))
+				ran = true;
 		}
 	}
-	while (rerun);
 
     return ran;
 }
@@ -264,88 +368,102 @@ bool vertex_unconfined(Graph &G, Vertex *v) {
 }
 
 bool vc_unconfined_rule(Graph &G) {
-	bool rerun;
 	bool ran = false;
+	vector<Vertex *> todo;
 
-	do {
-		rerun = false;
-		// iterate over all uncovered nodes
+	// until no vertex near a change is left
+	while (true) {
+		dirty_take(G, DIRTY_UNCONF, todo);
+		if (todo.empty())
+			break;
+
+		for (Vertex* v: todo) {
+			if (v->deg == 0)
+				continue;
 
-		list<Vertex *> list_V(G.V);
-		for (Vertex* v: list_V) {
 			if (vertex_unconfined(G, v)) {
 				add_to_vc(G, v);
 				ran = true;
-				rerun = true;
 
 				vc_deg1_rule(G);
 			}
 		}
 	}
-	while (rerun);
 	return ran;
 }
 
 bool vc_unconfined_rule_combo(Graph &G, long long &k) {
-	bool rerun;
 	bool ran = false;
+	vector<Vertex *> todo;
 
-	do {
-		rerun = false;
-		// iterate over all uncovered nodes
+	// until no vertex near a change is left
+	while (true) {
+		dirty_take(G, DIRTY_UNCONF, todo);
+		if (todo.empty())
+			break;
+
+		for (size_t i = 0; i < todo.size(); i++) {
+			Vertex *v = todo[i];
+
+			// the first pass over a large graph takes seconds
+			if (TIME_stop) {
+				dirty_requeue(G, DIRTY_UNCONF, todo, i);
+				return ran;
+			}
 
-		list<Vertex *> list_V(G.V);
-		for (Vertex* v: list_V) {
-			if (v->merge != nullptr)
+			if (v->deg == 0 || v->merge != nullptr)
 				continue;
 
 			if (vertex_unconfined(G, v)) {
 				add_to_vc(G, v);
 				ran = true;
-				rerun = true;
 
 				vc_deg1_rule(G);
 				vc_deg2_rule(G, k);
 			}
 		}
 	}
-	while (rerun);
 	return ran;
 }
 
 bool vc_clique_neigh_rule(Graph &G, long long &k) {
-	bool rerun;
 	bool ran = false;
+	vector<Vertex *> todo;
 
-	do {
-		rerun = false;
-		// iterate over all uncovered nodes
-		for (auto it = G.V.begin(); it != G.V.end(); ) {
-			Vertex *v = *it;
-			auto next = it;
-			next++;
-			it++;
-			Vertex *tmp = nullptr;
-			// keep track of the position in the list, because
-			// the list can get mangled in all sorts of ways.
-			// in the case of vc_clique_neigh_rule it is safe to modify G.V
-			it = G.V.insert(it, tmp);
-
-			if (vc_clique_neigh_single(G, v, k)) {
-				//rerun = true;
-				ran   = true;
-			}
+	// a single pass, the changes it makes are looked at next time
+	dirty_take(G, DIRTY_CN, todo);
+	for (Vertex *v: todo) {
+		if (v->deg == 0)
+			continue;
 
-			it = G.V.erase(it);
-		}
+		if (vc_clique_neigh_single(G, v, k))
+			ran = true;
 	}
-	while (rerun);
 	return ran;
 }
 
+// the row of stats_print each rule is counted in, by optimization_rules
+static const stat_kind rule_stat[] = {
+	NUM_STATS,
+	STAT_DEG_1,
+	STAT_DEG_2,
+	STAT_DEG_3,
+	STAT_DOM,
+	STAT_UNCONF,
+	STAT_CN,
+	STAT_LP,
+	STAT_DEG_12,
+	STAT_UNCONF_COMBO,
+	STAT_UNDEG_3,
+};
+
 void vc_execute_rrule(Graph &G, long long &k, optimization_rules rule) {
 	bool rerun = false;
 
+	if (rule == OPT_NONE)
+		return;
+	stat_scope scope(G, rule_stat[rule]);
+
 	switch (rule) {
 	case OPT_NONE:
 		break;
@@ -393,21 +511,157 @@ void vc_optimize(Graph &G, long long &k) {
 	}
 }
 
+// an expensive rule of vc_preoptimize and how well it did so far
+struct preopt_rule {
+	optimization_rules rule;
+
+	// what the last run changed per vertex and edge it had to look at
+	double rate = 0;
+	// runs in a row below PREOPT_MIN_RATE
+	size_t slow = 0;
+	bool retired = false;
+
+	preopt_rule(optimization_rules rule) : rule(rule) {};
+};
+
+// run rule, returns whether it changed the graph
+static bool preopt_run(Graph &G, long long &k, optimization_rules rule, double *rate = nullptr) {
+	size_t n     = G.V.size();
+	size_t m     = G.E.size();
+	size_t trail = G.trail.size();
+	size_t vc    = G.VC.V.size();
+	long long old_k = k;
+
+	vc_execute_rrule(G, k, rule);
+
+	// not the time it took, the schedule and so the kernel must not depend
+	// on the machine load. The expensive rules look at the whole graph, a
+	// fold changes the edges and can keep n, rules taking vertices lower k
+	if (rate != nullptr) {
+		size_t changed = (n > G.V.size() ? n - G.V.size() : G.V.size() - n)
+		               + (m > G.E.size() ? m - G.E.size() : G.E.size() - m)
+		               + (old_k > k ? old_k - k : 0);
+		*rate = (double) changed / max<size_t>(n + m, 1);
+	}
+
+	return G.V.size() != n || G.E.size() != m || G.trail.size() != trail || G.VC.V.size() != vc;
+}
+
+// the cheap rules until none of them applies anymore or time is up
+static bool preopt_cheap(Graph &G, long long &k) {
+	bool changed = false;
+
+	while (!TIME_stop) {
+		bool again = preopt_run(G, k, OPT_DEG_12);
+		again |= preopt_run(G, k, OPT_UNCONF_COMBO);
+		if (!again)
+			break;
+		changed = true;
+	}
+
+	return changed;
+}
+
+// an expensive rule, and the cheap ones again if it changed something
+static bool preopt_expensive(Graph &G, long long &k, optimization_rules rule, double *rate = nullptr) {
+	if (TIME_stop || !preopt_run(G, k, rule, rate))
+		return false;
+
+	preopt_cheap(G, k);
+	return true;
+}
+
+/* reduce the graph until no rule applies anymore
+ *
+ * the cheap rules run to a fixpoint first, then the expensive ones, the most
+ * productive first. An expensive rule that changes less than
+ * PREOPT_MIN_RATE of the graph PREOPT_PATIENCE times in a row is retired,
+ * it only runs again to confirm the fixpoint.
+ *
+ * the undeg3 rule can undo what the deg3 rule did, it runs at the end of
+ * every round. If PREOPT_PATIENCE rounds in a row end with the same n and m
+ * the two only go back and forth, so that counts as a fixpoint too
+ *
+ * once TIME_stop is set no rule starts anymore, the graph is reduced as far
+ * as we got
+ */
 void vc_preoptimize(Graph &G, long long &k) {
-	for (int i = 0; i < 50; i++) {
-		vc_execute_rrule(G, k, OPT_DEG_12);
-		vc_execute_rrule(G, k, OPT_UNCONF_COMBO);
-		vc_execute_rrule(G, k, OPT_LP);
-		vc_execute_rrule(G, k, OPT_CN);
-		vc_execute_rrule(G, k, OPT_LP);
-		vc_execute_rrule(G, k, OPT_DEG_3);
-
-		vc_execute_rrule(G, k, OPT_DEG_12);
-		vc_execute_rrule(G, k, OPT_UNCONF_COMBO);
-		vc_execute_rrule(G, k, OPT_LP);
-		vc_execute_rrule(G, k, OPT_CN);
-		vc_execute_rrule(G, k, OPT_LP);
-		vc_execute_rrule(G, k, OPT_UNDEG_3);
+	vector<preopt_rule> rules = {OPT_LP, OPT_CN, OPT_DEG_3};
+
+	size_t round;
+	bool done = false;
+	size_t last_n = G.V.size();
+	size_t last_m = G.E.size();
+	size_t stale  = 0;
+
+	for (round = 1; round <= PREOPT_MAX_ROUNDS && !done && !TIME_stop; round++) {
+		size_t n = G.V.size();
+		size_t m = G.E.size();
+		auto start = chrono::steady_clock::now();
+
+		bool changed = preopt_cheap(G, k);
+
+		stable_sort(rules.begin(), rules.end(), [](const preopt_rule &a, const preopt_rule &b) {
+			return a.rate > b.rate;
+		});
+
+		for (preopt_rule &r: rules) {
+			if (r.retired)
+				continue;
+
+			r.rate = 0;
+			changed |= preopt_expensive(G, k, r.rule, &r.rate);
+
+			r.slow = r.rate < PREOPT_MIN_RATE ? r.slow + 1 : 0;
+			if (r.slow >= PREOPT_PATIENCE)
+				r.retired = true;
+		}
+
+		changed |= preopt_expensive(G, k, OPT_UNDEG_3);
+
+		stale = G.V.size() == last_n && G.E.size() == last_m ? stale + 1 : 0;
+		done = !changed || stale >= PREOPT_PATIENCE;
+
+		// make sure the retired rules don't apply either
+		if (done && !TIME_stop) {
+			size_t confirm_n = G.V.size();
+			size_t confirm_m = G.E.size();
+			bool applied = false;
+
+			for (preopt_rule &r: rules) {
+				if (r.retired && preopt_expensive(G, k, r.rule, &r.rate)) {
+					applied   = true;
+					r.retired = false;
+					r.slow    = 0;
+				}
+			}
+
+			if (applied) {
+				preopt_expensive(G, k, OPT_UNDEG_3);
+				if (G.V.size() != confirm_n || G.E.size() != confirm_m) {
+					done  = false;
+					stale = 0;
+				}
+			}
+		}
+
+		last_n = G.V.size();
+		last_m = G.E.size();
+
+		double secs = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+		auto flags = cout.flags();
+		auto prec  = cout.precision();
+		cout << fixed << setprecision(3);
+		cout << "c preoptimize round " << round << ": n " << n << " -> " << G.V.size()
+		     << ", m " << m << " -> " << G.E.size() << " in " << secs << " s" << endl;
+		cout.flags(flags);
+		cout.precision(prec);
 	}
 
+	if (done)
+		cout << "c preoptimize: fixpoint after " << round - 1 << " rounds" << endl;
+	else if (TIME_stop)
+		cout << "c preoptimize: interrupted after " << round - 1 << " rounds" << endl;
+	else
+		cout << "c preoptimize: stopped after " << PREOPT_MAX_ROUNDS << " rounds" << endl;
 }
@@ -10,6 +10,8 @@ bool vc_domination_rule(Graph &G);
 bool vc_unconfined_rule(Graph &G);
 
 bool vc_deg2_rule_single(Graph &G, long long &k, Vertex *v);
+// whether v is unconfined, doesn't change the graph
+bool vertex_unconfined(Graph &G, Vertex *v);
 
 void vc_optimize(Graph &G, long long &k);
 void vc_preoptimize(Graph &G, long long &k);
@@ -76,4 +78,11 @@ public:
 
 extern size_t UNCONF_CUTOFF;
 extern size_t UNCONF_MAX_DEG;
+
+// vc_preoptimize stops after this many rounds even without a fixpoint
+extern size_t PREOPT_MAX_ROUNDS;
+// expensive rules changing less than this fraction of n + m are retired
+// after PREOPT_PATIENCE runs in a row
+extern double PREOPT_MIN_RATE;
+extern size_t PREOPT_PATIENCE;
 extern optimization_rules enabled_rules[NUM_RULES];
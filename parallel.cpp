@@ -0,0 +1,157 @@
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <chrono>
+
+#include "parallel.h"
+
+// tasks spawned by one thread. It takes the newest one itself, while other
+// threads steal the oldest ones, which tend to be the largest subtrees
+struct task_queue {
+	mutex lock;
+	deque<vc_task *> tasks;
+};
+
+static vector<thread> workers;
+static vector<task_queue> queues;
+
+static atomic<size_t> idle{0};
+static atomic<bool> stopping{false};
+// number of tasks in all queues
+static atomic<size_t> queued{0};
+
+// idle workers sleep here until there is a task to steal. Who wakes them
+// takes sleep_lock first, so the wakeup can't get lost between checking
+// and waiting
+static mutex sleep_lock;
+static condition_variable wake;
+
+static void pool_wake(bool all) {
+	{
+		lock_guard<mutex> lk(sleep_lock);
+	}
+	if (all)
+		wake.notify_all();
+	else
+		wake.notify_one();
+}
+
+// index of the current thread in queues, 0 is the thread calling pool_start
+static thread_local size_t self = 0;
+
+static vc_task *pool_take() {
+	task_queue &own = queues[self];
+	{
+		lock_guard<mutex> lk(own.lock);
+		if (!own.tasks.empty()) {
+			vc_task *t = own.tasks.back();
+			own.tasks.pop_back();
+			queued--;
+			return t;
+		}
+	}
+
+	for (size_t i = 1; i < queues.size(); i++) {
+		task_queue &q = queues[(self + i) % queues.size()];
+		lock_guard<mutex> lk(q.lock);
+		if (!q.tasks.empty()) {
+			vc_task *t = q.tasks.front();
+			q.tasks.pop_front();
+			queued--;
+			return t;
+		}
+	}
+
+	return nullptr;
+}
+
+static void pool_run(vc_task *t) {
+	t->run(t);
+	t->done.store(true, memory_order_release);
+}
+
+static void pool_worker(size_t id) {
+	self = id;
+
+	while (!stopping.load(memory_order_relaxed)) {
+		vc_task *t = pool_take();
+		if (t != nullptr) {
+			pool_run(t);
+			continue;
+		}
+
+		// the timeout is only a fallback
+		unique_lock<mutex> lk(sleep_lock);
+		idle++;
+		wake.wait_for(lk, chrono::milliseconds(100), [] {
+			return queued.load() > 0 || stopping.load();
+		});
+		idle--;
+	}
+}
+
+void pool_start(size_t threads) {
+	if (threads <= 1)
+		return;
+
+	vector<task_queue>(threads).swap(queues);
+	stopping = false;
+	self = 0;
+
+	for (size_t i = 1; i < threads; i++)
+		workers.emplace_back(pool_worker, i);
+}
+
+void pool_stop() {
+	stopping = true;
+	pool_wake(true);
+
+	for (thread &w: workers)
+		w.join();
+
+	workers.clear();
+	queues.clear();
+}
+
+bool pool_has_idle() {
+	return !workers.empty() && idle.load(memory_order_relaxed) > 0;
+}
+
+void pool_spawn(vc_task *t) {
+	task_queue &own = queues[self];
+	{
+		lock_guard<mutex> lk(own.lock);
+		own.tasks.push_back(t);
+	}
+	queued++;
+	pool_wake(false);
+}
+
+void pool_join(vc_task *t) {
+	// tasks spawned after t have been joined already, so if nobody stole t
+	// it's the newest one in our queue
+	task_queue &own = queues[self];
+	bool mine = false;
+	{
+		lock_guard<mutex> lk(own.lock);
+		if (!own.tasks.empty() && own.tasks.back() == t) {
+			own.tasks.pop_back();
+			queued--;
+			mine = true;
+		}
+	}
+	if (mine) {
+		pool_run(t);
+		return;
+	}
+
+	// help out until the thief is done with t
+	while (!t->done.load(memory_order_acquire)) {
+		vc_task *o = pool_take();
+		if (o != nullptr)
+			pool_run(o);
+		else
+			this_thread::yield();
+	}
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <atomic>
+#include <list>
+#include <vector>
+
+#include "graph.h"
+
+// a part of the search tree solved on a private copy of the graph
+struct vc_task {
+	Graph G;
+	// the vertex with id i in G is a copy of origin[i], see graph_copy
+	vector<Vertex *> origin;
+
+	// what to do with G, run by whichever thread picks up the task
+	void (*run)(vc_task *t);
+	// the branching vertex in G and which side of the branch to take
+	Vertex *v = nullptr;
+	int choice = 0;
+
+	// upper bound for the cover of G. When run returns, best is a smaller
+	// cover of the original vertices of G, or empty if there is none
+	long long u = 0;
+	list<Vertex *> best;
+	// the lower bound the search proved for the cover of G
+	long long bound = 0;
+
+	atomic<bool> done{false};
+
+	// the search restored G, so G.V holds all vertices of the copy again
+	~vc_task() {
+		for (Vertex *a: G.V)
+			a->~Vertex();
+	}
+};
+
+// start threads - 1 workers, the calling thread is the remaining one
+void pool_start(size_t threads);
+void pool_stop();
+
+// true if a worker is waiting for tasks, so spawning one pays off
+bool pool_has_idle();
+
+// hand t to the pool, pool_join must be called on it before it is freed
+void pool_spawn(vc_task *t);
+// wait for t to finish, runs t or other tasks in the meantime
+void pool_join(vc_task *t);
@@ -0,0 +1,381 @@
+#include <iostream>
+#include <iomanip>
+#include <cstring>
+#include <chrono>
+#include <vector>
+#include <cstdint>
+
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "graph.h"
+#include "csr.h"
+#include "parse.h"
+
+// size of the blocks read from a pipe, lines longer than this grow the buffer
+#define PARSE_BLOCK_SIZE (1 << 20)
+
+struct parse_state {
+	Graph &G;
+	string &td;
+	size_t &n;
+
+	// vertices are labelled 1..n, see Graph::label_map
+	bool int_mode = false;
+
+	// reused for name lookups, so we don't allocate a string per token
+	string key;
+
+	// vertices by id
+	vector<Vertex *> verts;
+
+	// edges as (min id << 32 | max id), duplicates are removed at the end
+	vector<uint64_t> edges;
+
+	// size of the input file, 0 for a pipe
+	size_t input_size = 0;
+
+	parse_state(Graph &G, string &td, size_t &n) : G(G), td(td), n(n) {};
+};
+
+static inline bool is_blank(char c) {
+	// "\r\n" line endings leave a '\r' at the end of each line
+	return c == ' ' || c == '\t' || c == '\r';
+}
+
+// returns the value of a name consisting only of digits, NO_LABEL otherwise
+// or if it has leading zeros, to_string(label) has to give back the name
+static size_t parse_label(const char *name, size_t len) {
+	if (len > 18 || (len > 1 && name[0] == '0'))
+		return NO_LABEL;
+
+	size_t label = 0;
+	for (size_t i = 0; i < len; i++) {
+		if (name[i] < '0' || name[i] > '9')
+			return NO_LABEL;
+		label = 10 * label + (name[i] - '0');
+	}
+
+	return label;
+}
+
+// a name is not in 1..n, from now on look up vertices by their name
+static void parse_leave_int_mode(parse_state &S) {
+	Graph &G = S.G;
+
+	for (Vertex *v: G.V) {
+		string name = to_string(v->label);
+
+		// vertices created for self loops share the name of their neighbour
+		auto it = G.name_map.find(name);
+		if (it != G.name_map.end()) {
+			v->label = it->second->label;
+			continue;
+		}
+
+		G.labels.push_back(name);
+		v->label = G.labels.size();
+		G.name_map[name] = v;
+	}
+
+	vector<Vertex *>().swap(G.label_map);
+	S.int_mode = false;
+}
+
+// find a vertex by name, create it if it doesn't already exist
+static Vertex *parse_vertex(parse_state &S, const char *name, size_t len) {
+	Graph &G = S.G;
+
+	if (S.int_mode) {
+		size_t label = parse_label(name, len);
+
+		if (label != NO_LABEL && label < G.label_map.size()) {
+			Vertex *&v = G.label_map[label];
+			if (v == nullptr) {
+				v = arena_new<Vertex>(G.arena, G.n, label);
+				G.V.push_back(v);
+				S.verts.push_back(v);
+				G.n++;
+			}
+			return v;
+		}
+
+		parse_leave_int_mode(S);
+	}
+
+	S.key.assign(name, len);
+	auto it = G.name_map.lower_bound(S.key);
+	if (it != G.name_map.end() && it->first == S.key)
+		return it->second;
+
+	G.labels.push_back(S.key);
+	Vertex *v = arena_new<Vertex>(G.arena, G.n, G.labels.size());
+
+	// map the name of the vertex to an id
+	G.name_map.insert(it, make_pair(S.key, v));
+	G.V.push_back(v);
+	S.verts.push_back(v);
+	G.n++;
+
+	return v;
+}
+
+static inline void parse_edge(parse_state &S, Vertex *a, Vertex *b) {
+	uint64_t x = a->id;
+	uint64_t y = b->id;
+
+	if (x > y)
+		swap(x, y);
+	S.edges.push_back(x << 32 | y);
+}
+
+// LSD radix sort, digits that are the same for all keys are skipped
+static void radix_sort(vector<uint64_t> &keys) {
+	vector<uint64_t> tmp(keys.size());
+
+	for (int shift = 0; shift < 64; shift += 8) {
+		size_t count[257] = {0};
+
+		for (uint64_t key: keys)
+			count[((key >> shift) & 0xff) + 1]++;
+
+		if (count[((keys[0] >> shift) & 0xff) + 1] == keys.size())
+			continue;
+
+		for (int i = 0; i < 256; i++)
+			count[i + 1] += count[i];
+
+		for (uint64_t key: keys)
+			tmp[count[(key >> shift) & 0xff]++] = key;
+
+		keys.swap(tmp);
+	}
+}
+
+// create the edges collected by parse_edge, without duplicates
+static void parse_create_edges(parse_state &S) {
+	Graph &G = S.G;
+
+	if (S.edges.empty())
+		return;
+
+	radix_sort(S.edges);
+
+	size_t m = 0;
+	for (size_t i = 0; i < S.edges.size(); i++) {
+		if (i > 0 && S.edges[i] == S.edges[i - 1])
+			continue;
+
+		uint64_t a = S.edges[i] >> 32;
+		uint64_t b = S.edges[i] & 0xffffffff;
+
+		if (a == b) {
+			// create a new vertex with the same name
+			Vertex *cov = arena_new<Vertex>(G.arena, G.n, S.verts[a]->label);
+			G.V.push_back(cov);
+			G.n++;
+
+			b = S.verts.size();
+			S.verts.push_back(cov);
+		}
+
+		S.edges[m++] = a << 32 | b;
+	}
+	S.edges.resize(m);
+
+	// the edge lists won't have to grow while adding the edges
+	vector<uint32_t> deg(S.verts.size(), 0);
+	for (uint64_t key: S.edges) {
+		deg[key >> 32]++;
+		deg[key & 0xffffffff]++;
+	}
+	for (size_t i = 0; i < S.verts.size(); i++)
+		S.verts[i]->edges.reserve(deg[i]);
+
+	for (uint64_t key: S.edges) {
+		Vertex *a = S.verts[key >> 32];
+		Vertex *b = S.verts[key & 0xffffffff];
+
+		// create the edge
+		Edge *e = arena_new<Edge>(G.arena, G.m, a, b);
+
+		G.E.push_back(e);
+		auto it = G.E.end();
+		it--;
+		e->iterE = it;
+
+		G.m++;
+	}
+
+	vector<uint64_t>().swap(S.edges);
+}
+
+// parse the line [p, end), the newline is not included
+static bool parse_line(parse_state &S, const char *p, const char *end) {
+	if (p == end || *p == 'c')
+		return true;
+
+	// split the line into at most 4 tokens
+	const char *tok[4];
+	size_t len[4];
+	int n_tok = 0;
+
+	while (p != end) {
+		while (p != end && is_blank(*p))
+			p++;
+		if (p == end)
+			break;
+
+		if (n_tok == 4)
+			return false;
+
+		tok[n_tok] = p;
+		while (p != end && !is_blank(*p))
+			p++;
+		len[n_tok] = p - tok[n_tok];
+		n_tok++;
+	}
+
+	if (n_tok == 0)
+		return true;
+
+	if (tok[0][0] == 'p') {
+		if (n_tok < 3)
+			return false;
+
+		S.td.assign(tok[1], len[1]);
+
+		size_t val = 0;
+		for (size_t i = 0; i < len[2]; i++) {
+			if (tok[2][i] < '0' || tok[2][i] > '9')
+				return false;
+			val = 10 * val + (tok[2][i] - '0');
+		}
+		S.n = val;
+
+		// don't trust n and m for allocations, an edge line takes at least
+		// 4 bytes. A pipe's size isn't known, allow a block's worth then
+		size_t max_m = (S.input_size > 0 ? S.input_size : PARSE_BLOCK_SIZE) / 4;
+
+		// the header gives us the number of vertices, index them directly
+		if (S.n > 0 && S.n <= 2 * max_m && S.G.V.empty()) {
+			S.int_mode = true;
+			S.G.label_map.assign(S.n + 1, nullptr);
+		}
+		if (n_tok == 4)
+			S.edges.reserve(min(parse_label(tok[3], len[3]), max_m));
+		return true;
+	}
+
+	if (n_tok != 2)
+		return false;
+
+	// the two verticies of the edge
+	Vertex *a = parse_vertex(S, tok[0], len[0]);
+	Vertex *b = parse_vertex(S, tok[1], len[1]);
+
+	parse_edge(S, a, b);
+	return true;
+}
+
+// parse all complete lines in [p, end)
+// returns the start of the trailing incomplete line, or nullptr on an error
+// if final is set the trailing line is parsed as well
+static const char *parse_block(parse_state &S, const char *p, const char *end, bool final) {
+	while (p != end) {
+		const char *nl = (const char *) memchr(p, '\n', end - p);
+		if (nl == nullptr) {
+			if (!final)
+				return p;
+			nl = end;
+		}
+
+		if (!parse_line(S, p, nl))
+			return nullptr;
+
+		p = nl == end ? end : nl + 1;
+	}
+
+	return p;
+}
+
+// read the whole file at once, the kernel pages it in for us
+static bool parse_mapped(parse_state &S, int fd, size_t size) {
+	void *map = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+	if (map == MAP_FAILED)
+		return false;
+	madvise(map, size, MADV_SEQUENTIAL);
+
+	const char *p = (const char *) map;
+	bool ok = parse_block(S, p, p + size, true) != nullptr;
+
+	munmap(map, size);
+	return ok;
+}
+
+// read from a pipe in large blocks
+static bool parse_stream(parse_state &S, int fd, size_t &bytes) {
+	vector<char> buf(PARSE_BLOCK_SIZE);
+	size_t have = 0;
+
+	while (true) {
+		if (have == buf.size())
+			buf.resize(2 * buf.size());
+
+		ssize_t r = read(fd, buf.data() + have, buf.size() - have);
+		if (r < 0)
+			return false;
+		if (r == 0)
+			break;
+
+		bytes += r;
+		have  += r;
+
+		const char *rest = parse_block(S, buf.data(), buf.data() + have, false);
+		if (rest == nullptr)
+			return false;
+
+		// keep the incomplete line for the next block
+		size_t consumed = rest - buf.data();
+		memmove(buf.data(), rest, have - consumed);
+		have -= consumed;
+	}
+
+	return parse_block(S, buf.data(), buf.data() + have, true) != nullptr;
+}
+
+bool parse_graph(Graph &G, int fd, string &td, size_t &n) {
+	auto start = chrono::steady_clock::now();
+
+	parse_state S(G, td, n);
+	size_t bytes = 0;
+	bool ok;
+
+	struct stat st;
+	if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+		bytes = st.st_size;
+		S.input_size = bytes;
+		ok = parse_mapped(S, fd, bytes);
+	}
+	else {
+		ok = parse_stream(S, fd, bytes);
+	}
+
+	if (!ok)
+		return false;
+
+	parse_create_edges(S);
+	csr_build_core(G);
+
+	double secs = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+	double mb = bytes / 1e6;
+	auto flags = cout.flags();
+	auto prec  = cout.precision();
+	cout << fixed << setprecision(2);
+	cout << "c parse: " << mb << " MB in " << secs << " s (" << (secs > 0 ? mb / secs : 0.0) << " MB/s)" << endl;
+	cout.flags(flags);
+	cout.precision(prec);
+
+	return true;
+}
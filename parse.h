@@ -0,0 +1,9 @@
+#pragma once
+
+#include <string>
+
+#include "graph.h"
+
+// read a graph in DIMACS/PACE format from the file descriptor fd into G
+// returns false on a parsing error
+bool parse_graph(Graph &G, int fd, string &td, size_t &n);
@@ -3,6 +3,8 @@
 #include "graph.h"
 #include "merge.h"
 #include "deg3.h"
+#include "clique_neigh.h"
+#include "undeg3.h"
 #include "read_vc.h"
 
 void rvc_add_vertex(Vertex *v, list<Vertex *> &sol) {
@@ -39,12 +41,30 @@ void read_vc(Graph &G, list<Vertex *> &sol) {
 	
 	//check_vc(G);
 
-	for (size_t i = 0; i < G.changes.size(); i++) {
-		size_t j = G.changes.size() - i - 1;
-		GraphModification *op = G.changes[j];
+	for (size_t i = 0; i < G.trail.size(); i++) {
+		trail_entry &t = G.trail[G.trail.size() - i - 1];
 
-		op->translate_vc(G, sol);
-		//op->undo(G); // it should also work without this (maybe)
+		switch (t.type) {
+		case TRAIL_EDGE_DELETION:
+		case TRAIL_PAIR_U:
+		case TRAIL_PAIR_V:
+		case TRAIL_DIRTY_TAKE:
+		case TRAIL_CORE_TOUCH:
+			// nothing to do
+			break;
+		case TRAIL_VERTEX_MERGE:
+			((MergedVertex *) t.ptr)->translate_vc(sol);
+			break;
+		case TRAIL_DEG3:
+			((GM_deg3 *) t.ptr)->translate_vc(G, sol);
+			break;
+		case TRAIL_CLIQUE_NEIGH:
+			((GM_clique_neigh *) t.ptr)->translate_vc(G, sol);
+			break;
+		case TRAIL_UNDEG3:
+			((GM_undeg3 *) t.ptr)->translate_vc(G, sol);
+			break;
+		}
 		//check_vc(G);
 	}
 }
@@ -3,103 +3,80 @@
 #include "graph.h"
 #include "merge.h"
 #include "deg3.h"
+#include "clique_neigh.h"
+#include "undeg3.h"
 #include "bipart.h"
 #include "snapshot.h"
 
+// the neighbourhood of v changed, tell the rules keeping a dirty queue
+static inline void mark_dirty(Graph &G, Vertex *v) {
+	if (G.undoing)
+		return;
+
+	uint8_t todo = G.dirty_active & ~v->dirty;
+	if (todo == 0)
+		return;
+
+	for (int r = 0; r < NUM_DIRTY; r++) {
+		if (todo & (1 << r))
+			G.dirty[r].push_back(v);
+	}
+	v->dirty |= todo;
+}
+
 /* change the degree of a vertex
  * takes care of placing v in the correct lists
  */
 void vert_change_deg(Graph &G, Vertex *v, size_t new_deg) {
+	mark_dirty(G, v);
+
 	if (v->deg == new_deg)
 		return;
 
-	if (v->deg == 0) {
-		v->deg = new_deg;
+	if (v->deg == 1)
+		G.deg1s.erase(v);
+	else if (v->deg == 2)
+		G.deg2s.erase(v);
+	else if (v->deg == 3)
+		G.deg3s.erase(v);
 
+	if (v->deg == 0)
 		G.V.push_back(v);
-		auto it = G.V.end();
-		it--;
-		v->iterV = it;
-
-		if (v->deg == 1) {
-			G.deg1s.push_back(v);
-			it = G.deg1s.end();
-			it--;
-			v->iter1 = it;
-		}
-		else if (v->deg == 2) {
-			G.deg2s.push_back(v);
-			it = G.deg2s.end();
-			it--;
-			v->iter2 = it;
-		}
-		else if (v->deg == 3) {
-			G.deg3s.push_back(v);
-			it = G.deg3s.end();
-			it--;
-			v->iter3 = it;
-		}
-	}
-	else if (new_deg == 0) {
-		if (v->deg == 1)
-			G.deg1s.erase(v->iter1);
-		else if (v->deg == 2)
-			G.deg2s.erase(v->iter2);
-		else if (v->deg == 3)
-			G.deg3s.erase(v->iter3);
-		G.V.erase(v->iterV);
-
-		v->deg = 0;
-	}
-	else {
-		if (v->deg == 1)
-			G.deg1s.erase(v->iter1);
-		else if (v->deg == 2)
-			G.deg2s.erase(v->iter2);
-		else if (v->deg == 3)
-			G.deg3s.erase(v->iter3);
-
-		if (new_deg == 1) {
-			G.deg1s.push_back(v);
-			auto it = G.deg1s.end();
-			it--;
-			v->iter1 = it;
-		}
-		else if (new_deg == 2) {
-			G.deg2s.push_back(v);
-			auto it = G.deg2s.end();
-			it--;
-			v->iter2 = it;
-		}
-		else if (new_deg == 3) {
-			G.deg3s.push_back(v);
-			auto it = G.deg3s.end();
-			it--;
-			v->iter3 = it;
-		}
-
-		v->deg = new_deg;
+	else
+		G.buckets.erase(v);
+
+	if (new_deg == 0)
+		G.V.erase(v);
+	else if (new_deg == 1)
+		G.deg1s.push_back(v);
+	else if (new_deg == 2)
+		G.deg2s.push_back(v);
+	else if (new_deg == 3)
+		G.deg3s.push_back(v);
+
+	v->deg = new_deg;
+	if (new_deg > 0)
+		G.buckets.insert(v);
+
+	if (v->id < G.core.n) {
+		G.core.deg[v->id]   = new_deg;
+		G.core.alive[v->id] = new_deg > 0;
 	}
 }
 
-void register_edge_deletion(Graph &G, Edge *e) {
-	GM_Edge_Deletion *last = nullptr;
-	bool merged = false;
+void core_touch(Graph &G, Vertex *v) {
+	if (G.undoing || !core_clean(G, v))
+		return;
 
-	if (G.changes.size() != 0) {
-		// if the last transformation was an edge deletion merge them
-		last = dynamic_cast<GM_Edge_Deletion *> (G.changes.back());
-		merged = last != nullptr;
-	}
+	G.core.clean[v->id] = 0;
 
-	if (last == nullptr) {
-		last = new GM_Edge_Deletion();
-	}
+	// like the dirty queues nothing is undone outside of a snapshot
+	if (G.snapshots > 0)
+		trail_push(G, TRAIL_CORE_TOUCH, v);
+}
 
-	last->edges.push_back(e);
-	if (!merged) {
-		G.changes.push_back(last);
-	}
+void trail_push(Graph &G, trail_type type, void *ptr, void *aux) {
+	G.trail.push_back({type, ptr, aux});
 }
 
 void move_edge_dirty(size_t pos, int i, Vertex *v, vector< pair<Vertex *, Edge *> > &from, vector< pair<Vertex *, Edge *> > &to) {
@@ -148,7 +125,7 @@ void delete_vertex(Graph &G, Vertex *v) {
 		assert(v->covered[e->pos[0]].first == u);
 
 		// add the edge to the covered edges
-		register_edge_deletion(G, e);
+		trail_push(G, TRAIL_EDGE_DELETION, e);
 		G.VC.E.push_back(e);
 		G.E.erase(e->iterE);
 
@@ -185,13 +162,20 @@ struct graph_snapshot create_snapshot(Graph &G) {
 
 	snapshot.vc.num_vertices = G.VC.V.size();
 	snapshot.vc.num_edges    = G.VC.E.size();
-	snapshot.num_changes     = G.changes.size();
+	snapshot.num_trail       = G.trail.size();
 
 	snapshot.num_constraints = G.constraints.size();
 	snapshot.num_marked_uncertain = G.marked_uncertain.size();
 
-	// create first graph modification entry
-	G.changes.push_back(new GM_Edge_Deletion());
+	snapshot.matching = G.matching;
+	snapshot.arena = G.arena.get_mark();
+
+	for (int r = 0; r < NUM_DIRTY; r++) {
+		snapshot.num_dirty[r] = G.dirty[r].size();
+		snapshot.num_dirty_taken[r] = G.dirty_taken[r].size();
+	}
+	snapshot.dirty_active = G.dirty_active;
+	G.snapshots++;
 
 	return snapshot;
 }
@@ -235,15 +219,49 @@ void uncover_edge(Graph &G, Edge *e) {
 	e->iterE = it;
 }
 
-void GM_Edge_Deletion::undo(Graph &G) {
-	for (Edge *e: this->edges) {
-		uncover_edge(G, e);
+// undo a graph modification and destroy its record
+// the memory is given back by G.arena.release in restore_snapshot
+// taken dirty queues go to taken, restore_snapshot puts back the oldest
+static void trail_undo(Graph &G, trail_entry &t, vector<Vertex *> *taken) {
+	switch (t.type) {
+	case TRAIL_EDGE_DELETION:
+		uncover_edge(G, (Edge *) t.ptr);
+		break;
+	case TRAIL_VERTEX_MERGE:
+		((MergedVertex *) t.ptr)->~MergedVertex();
+		break;
+	case TRAIL_DEG3: {
+		GM_deg3 *op = (GM_deg3 *) t.ptr;
+		op->undo(G);
+		op->~GM_deg3();
+		break;
+	}
+	case TRAIL_CLIQUE_NEIGH: {
+		GM_clique_neigh *op = (GM_clique_neigh *) t.ptr;
+		op->undo(G);
+		op->~GM_clique_neigh();
+		break;
+	}
+	case TRAIL_UNDEG3: {
+		GM_undeg3 *op = (GM_undeg3 *) t.ptr;
+		op->undo(G);
+		op->~GM_undeg3();
+		break;
+	}
+	case TRAIL_PAIR_U:
+	case TRAIL_PAIR_V:
+		bp_restore_pair(G, (Vertex *) t.ptr, t.type == TRAIL_PAIR_U ? 0 : 1, (Vertex *) t.aux);
+		break;
+	case TRAIL_CORE_TOUCH:
+		G.core.clean[((Vertex *) t.ptr)->id] = 1;
+		break;
+	case TRAIL_DIRTY_TAKE: {
+		uintptr_t r = (uintptr_t) t.aux;
+		taken[r].swap(G.dirty_taken[r].back());
+		G.dirty_taken[r].pop_back();
+		break;
+	}
 	}
-}
-
-void GM_Edge_Deletion::translate_vc(Graph &G, list<Vertex *> &sol) {
-	// nothing to do
-	return;
 }
 
 void restore_snapshot(Graph &G, struct graph_snapshot &s)
@@ -262,14 +280,42 @@ void restore_snapshot(Graph &G, struct graph_snapshot &s)
 	}
 	G.marked_uncertain.erase(G.marked_uncertain.begin() + s.num_marked_uncertain, G.marked_uncertain.end());
 
+	// the rules have to look at the same vertices as at the snapshot again.
+	// Unmark the ones queued since, before the vertices created since then
+	// are destroyed. A queue no rule took since only grew
+	bool taken_since[NUM_DIRTY];
+	for (int r = 0; r < NUM_DIRTY; r++) {
+		taken_since[r] = G.dirty_taken[r].size() > s.num_dirty_taken[r];
+		size_t keep = taken_since[r] ? 0 : s.num_dirty[r];
+		for (size_t i = keep; i < G.dirty[r].size(); i++)
+			G.dirty[r][i]->dirty &= ~(1 << r);
+		G.dirty[r].resize(keep);
+	}
+	G.dirty_active = s.dirty_active;
+
 	// undo graph transformations
-	for (size_t i = 0; i < G.changes.size() - s.num_changes; i++) {
-		size_t j = G.changes.size() - i - 1;
-		GraphModification *op = G.changes[j];
-		op->undo(G);
-		delete op;
+	vector<Vertex *> taken[NUM_DIRTY];
+	G.trail_undone += G.trail.size() - s.num_trail;
+	G.undoing = true;
+	while (G.trail.size() > s.num_trail) {
+		trail_undo(G, G.trail.back(), taken);
+		G.trail.pop_back();
+	}
+	G.undoing = false;
+
+	// the oldest queue taken since the snapshot starts with the one we had
+	for (int r = 0; r < NUM_DIRTY; r++) {
+		if (!taken_since[r])
+			continue;
+
+		taken[r].resize(min(taken[r].size(), s.num_dirty[r]));
+		for (Vertex *v: taken[r])
+			v->dirty |= 1 << r;
+		G.dirty[r].swap(taken[r]);
 	}
-	G.changes.erase(G.changes.begin() + s.num_changes, G.changes.end());
+
+	// the matching is the one we had at the snapshot again
+	G.matching = s.matching;
 
 	// erase the edges from the VC
 	G.VC.E.erase(G.VC.E.begin() + s.vc.num_edges, G.VC.E.end());
@@ -279,5 +325,9 @@ void restore_snapshot(Graph &G, struct graph_snapshot &s)
 		delete G.constraints[i];
 	}
 	G.constraints.erase(G.constraints.begin() + s.num_constraints, G.constraints.end());
+
+	// everything created since the snapshot is gone now
+	G.arena.release(s.arena);
+	G.snapshots--;
 }
 
@@ -2,8 +2,19 @@
 
 struct graph_snapshot;
 
+#include <cstdint>
+
+#include "arena.h"
 #include "graph.h"
 
+// rules that only look at the vertices near a change, see Graph::dirty
+enum dirty_rule {
+	DIRTY_DOM,
+	DIRTY_UNCONF,
+	DIRTY_CN,
+	NUM_DIRTY
+};
+
 struct graph_snapshot {
 
 	struct vc_snapshot {
@@ -11,32 +22,50 @@ struct graph_snapshot {
 		size_t num_edges;
 	} vc;
 
-	size_t num_changes;
+	size_t num_trail;
 	size_t num_constraints;
 	size_t num_marked_uncertain;
-};
+	size_t matching;
 
+	Arena::mark arena;
+
+	// the queues only grow until a rule takes them, see TRAIL_DIRTY_TAKE
+	size_t num_dirty[NUM_DIRTY];
+	size_t num_dirty_taken[NUM_DIRTY];
+	uint8_t dirty_active;
+};
 
-class GraphModification {
-public:
-	virtual void undo(Graph &G) = 0;	
-	virtual void translate_vc(Graph &G, list<Vertex *> &sol) = 0;
 
-	virtual ~GraphModification() {};
+// kinds of entries on the undo trail
+enum trail_type : uint8_t {
+	TRAIL_EDGE_DELETION,  // ptr is the covered Edge
+	TRAIL_VERTEX_MERGE,   // ptr is the MergedVertex
+	TRAIL_DEG3,           // ptr is a GM_deg3
+	TRAIL_CLIQUE_NEIGH,   // ptr is a GM_clique_neigh
+	TRAIL_UNDEG3,         // ptr is a GM_undeg3
+	TRAIL_PAIR_U,         // ptr is a Vertex, aux its previous left partner
+	TRAIL_PAIR_V,         // ptr is a Vertex, aux its previous right partner
+	TRAIL_DIRTY_TAKE,     // aux is a dirty_rule, its queue is on Graph::dirty_taken
+	TRAIL_CORE_TOUCH,     // ptr is a Vertex that was clean in Graph::core
 };
 
-class GM_Edge_Deletion : public GraphModification {
-public:
-	vector<Edge *> edges;
-	virtual void undo(Graph &G);
-	virtual void translate_vc(Graph &G, list<Vertex *> &sol);
+// a graph modification, restore_snapshot undoes them in reverse order
+struct trail_entry {
+	trail_type type;
+	void *ptr;
+	void *aux;
 };
 
+void trail_push(Graph &G, trail_type type, void *ptr, void *aux = nullptr);
+
 void restore_snapshot(Graph &G, struct graph_snapshot &s);
 struct graph_snapshot create_snapshot(Graph &G);
 
 void add_to_vc(Graph &G, Vertex *a);
 void delete_vertex(Graph &G, Vertex *a);
 void vert_change_deg(Graph &G, Vertex *v, size_t new_deg);
+// an edge of v was added, moved or removed other than by deleting the
+// vertex at its other end, v's row in G.core doesn't match anymore
+void core_touch(Graph &G, Vertex *v);
 
 void move_edge_dirty(size_t pos, int i, Vertex *v, vector< pair<Vertex *, Edge *> > &from, vector< pair<Vertex *, Edge *> > &to);
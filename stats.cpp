@@ -1,4 +1,193 @@
+#include <fstream>
+#include <iomanip>
+#include <mutex>
+
 #include "graph.h"
+#include "stats.h"
+
+string STATS_JSON;
+string SEARCH_CSV;
+
+static const char *stat_names[NUM_STATS] = {
+	"deg1",
+	"deg2",
+	"deg3",
+	"domination",
+	"unconfined",
+	"clique_neigh",
+	"lp",
+	"deg12",
+	"unconfined_combo",
+	"undeg3",
+	"lp_bound",
+	"clique_bound",
+	"mirrors",
+	"split",
+};
+
+static const char *outcome_names[NUM_OUTCOMES] = {
+	"branched",
+	"solved",
+	"split",
+	"lp",
+	"clique",
+	"k2",
+	"incumbent",
+};
+
+// the counters of the threads that exited already
+static stats_thread stats_total;
+static mutex stats_lock;
+
+// to convert ticks to ns
+static const uint64_t stats_start_ticks = stats_ticks();
+static const auto stats_start_time = chrono::steady_clock::now();
+
+static void stats_add(stats_thread &to, const stats_thread &from) {
+	for (int i = 0; i < NUM_STATS; i++) {
+		to.rules[i].calls    += from.rules[i].calls;
+		to.rules[i].applied  += from.rules[i].applied;
+		to.rules[i].vertices += from.rules[i].vertices;
+		to.rules[i].edges    += from.rules[i].edges;
+		to.rules[i].ticks    += from.rules[i].ticks;
+	}
+
+	if (to.depths.size() < from.depths.size())
+		to.depths.resize(from.depths.size());
+	for (size_t d = 0; d < from.depths.size(); d++) {
+		depth_stats &a = to.depths[d];
+		const depth_stats &b = from.depths[d];
+
+		for (int i = 0; i < NUM_OUTCOMES; i++)
+			a.nodes[i] += b.nodes[i];
+		if (b.gaps == 0)
+			continue;
+		a.gap_min = a.gaps == 0 ? b.gap_min : min(a.gap_min, b.gap_min);
+		a.gap_max = a.gaps == 0 ? b.gap_max : max(a.gap_max, b.gap_max);
+		a.gaps    += b.gaps;
+		a.gap_sum += b.gap_sum;
+	}
+}
+
+// adds the counters of a thread to the totals when it exits
+struct stats_exit {
+	stats_thread s;
+
+	~stats_exit() {
+		lock_guard<mutex> lock(stats_lock);
+		stats_add(stats_total, s);
+	}
+};
+
+stats_thread &stats_local() {
+	static thread_local stats_exit t;
+	return t.s;
+}
+
+depth_stats &stats_depth(size_t depth) {
+	vector<depth_stats> &depths = stats_local().depths;
+	if (depth >= depths.size())
+		depths.resize(depth + 1);
+	return depths[depth];
+}
+
+static void stats_print_rules(const stats_thread &all) {
+	double ns = chrono::duration<double, nano>(chrono::steady_clock::now() - stats_start_time).count();
+	uint64_t ticks = stats_ticks() - stats_start_ticks;
+	double ns_per_tick = ticks > 0 ? ns / ticks : 0;
+
+	auto flags = cout.flags();
+	auto prec  = cout.precision();
+	cout << fixed << setprecision(3);
+	for (int i = 0; i < NUM_STATS; i++) {
+		const rule_stats &s = all.rules[i];
+		if (s.calls == 0)
+			continue;
+
+		cout << "c rule " << stat_names[i] << ": calls " << s.calls << ", applied " << s.applied
+		     << ", vertices " << s.vertices << ", edges " << s.edges
+		     << ", " << s.ticks * ns_per_tick / 1e6 << " ms" << endl;
+	}
+	cout.flags(flags);
+	cout.precision(prec);
+
+	if (STATS_JSON.empty())
+		return;
+
+	ofstream out(STATS_JSON);
+	out << "{\"rules\": [";
+	bool first = true;
+	for (int i = 0; i < NUM_STATS; i++) {
+		const rule_stats &s = all.rules[i];
+		if (s.calls == 0)
+			continue;
+
+		out << (first ? "" : ",") << "\n  {\"name\": \"" << stat_names[i] << "\", \"calls\": " << s.calls
+		    << ", \"applied\": " << s.applied << ", \"vertices\": " << s.vertices
+		    << ", \"edges\": " << s.edges << ", \"ns\": " << (uint64_t) (s.ticks * ns_per_tick) << "}";
+		first = false;
+	}
+	out << "\n]}\n";
+}
+
+static void stats_print_search(const stats_thread &all) {
+	uint64_t total[NUM_OUTCOMES] = {};
+	uint64_t nodes = 0;
+	for (const depth_stats &d: all.depths) {
+		for (int i = 0; i < NUM_OUTCOMES; i++) {
+			total[i] += d.nodes[i];
+			nodes    += d.nodes[i];
+		}
+	}
+
+	if (nodes == 0)
+		return;
+
+	cout << "c search nodes: " << nodes << ", depth " << all.depths.size() - 1 << endl;
+	cout << "c search outcomes:";
+	for (int i = 0; i < NUM_OUTCOMES; i++)
+		cout << (i > 0 ? ", " : " ") << outcome_names[i] << " " << total[i];
+	cout << endl;
+
+	if (SEARCH_CSV.empty())
+		return;
+
+	ofstream out(SEARCH_CSV);
+	out << "depth,nodes";
+	for (int i = 0; i < NUM_OUTCOMES; i++)
+		out << "," << outcome_names[i];
+	out << ",gaps,gap_mean,gap_min,gap_max\n";
+
+	for (size_t depth = 0; depth < all.depths.size(); depth++) {
+		const depth_stats &d = all.depths[depth];
+
+		uint64_t n = 0;
+		for (int i = 0; i < NUM_OUTCOMES; i++)
+			n += d.nodes[i];
+
+		out << depth << "," << n;
+		for (int i = 0; i < NUM_OUTCOMES; i++)
+			out << "," << d.nodes[i];
+
+		if (d.gaps > 0)
+			out << "," << d.gaps << "," << (double) d.gap_sum / d.gaps << "," << d.gap_min << "," << d.gap_max << "\n";
+		else
+			out << ",0,,,\n";
+	}
+}
+
+void stats_print() {
+	// the threads of the pool are gone, only ours is left
+	stats_thread all;
+	{
+		lock_guard<mutex> lock(stats_lock);
+		stats_add(all, stats_total);
+		stats_add(all, stats_local());
+	}
+
+	stats_print_rules(all);
+	stats_print_search(all);
+}
 
 
 void print_graph_optimization(Graph &G) {
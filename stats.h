@@ -1,5 +1,152 @@
 #pragma once
 
+#include <cstdint>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
 #include "graph.h"
 
 void print_graph_optimization(Graph &G);
+
+
+/* per rule profiling, printed as c lines by stats_print
+ *
+ * times are taken from the time stamp counter and only converted to ns at
+ * the end. Compile with -DNO_RULE_STATS to turn it all into no-ops
+ */
+enum stat_kind {
+	STAT_DEG_1,
+	STAT_DEG_2,
+	STAT_DEG_3,
+	STAT_DOM,
+	STAT_UNCONF,
+	STAT_CN,
+	STAT_LP,
+	STAT_DEG_12,
+	STAT_UNCONF_COMBO,
+	STAT_UNDEG_3,
+	STAT_LP_BOUND,     // includes the calls of the LP rule
+	STAT_CLIQUE_BOUND,
+	STAT_MIRRORS,
+	STAT_SPLIT,        // finding the components, not solving them
+	NUM_STATS
+};
+
+struct rule_stats {
+	uint64_t calls    = 0;
+	// calls that changed the graph or the cover
+	uint64_t applied  = 0;
+	// removed from G.V and G.E
+	uint64_t vertices = 0;
+	uint64_t edges    = 0;
+	uint64_t ticks    = 0;
+};
+
+static inline uint64_t stats_ticks() {
+#if defined(__x86_64__) || defined(__i386__)
+	return __rdtsc();
+#else
+	return chrono::steady_clock::now().time_since_epoch().count();
+#endif
+}
+
+/* search tree telemetry of vc_branch and vc_branch_v2, by depth */
+// what happened at a node of the search tree
+enum node_outcome {
+	NODE_BRANCHED,
+	NODE_SOLVED,     // no vertices left
+	NODE_SPLIT,      // solved as independent components
+	NODE_LP,         // pruned by the LP bound
+	NODE_CLIQUE,     // pruned by the clique bound
+	NODE_K2,         // pruned by the k^2 kernel size bound
+	NODE_INCUMBENT,  // pruned by the bound of 1, the incumbent (or k) was reached
+	NUM_OUTCOMES
+};
+
+struct depth_stats {
+	uint64_t nodes[NUM_OUTCOMES] = {};
+
+	// gap between the lower bound of a branched node and the cover its
+	// subtree was closed with, the best one found or the incumbent
+	uint64_t  gaps    = 0;
+	long long gap_sum = 0;
+	long long gap_min = 0;
+	long long gap_max = 0;
+};
+
+struct stats_thread {
+	rule_stats rules[NUM_STATS];
+	vector<depth_stats> depths;
+};
+
+// the counters of the calling thread, added to the totals when it exits
+stats_thread &stats_local();
+
+depth_stats &stats_depth(size_t depth);
+
+static inline void stats_node(size_t depth, node_outcome outcome) {
+	stats_depth(depth).nodes[outcome]++;
+}
+
+static inline void stats_gap(size_t depth, long long gap) {
+	depth_stats &d = stats_depth(depth);
+	d.gap_min = d.gaps == 0 ? gap : min(d.gap_min, gap);
+	d.gap_max = d.gaps == 0 ? gap : max(d.gap_max, gap);
+	d.gaps++;
+	d.gap_sum += gap;
+}
+
+// print the counters as c lines, the rules as JSON to STATS_JSON and the
+// search tree as CSV to SEARCH_CSV if they are set
+void stats_print();
+
+#ifndef NO_RULE_STATS
+// counts the time until it goes out of scope and what happened to G meanwhile
+class stat_scope {
+public:
+	stat_scope(Graph &G, stat_kind kind)
+	: G(G), kind(kind), n(G.V.size()), m(G.E.size()), vc(G.VC.V.size()), start(stats_ticks()) {};
+
+	~stat_scope() {
+		rule_stats &s = stats_local().rules[kind];
+		s.ticks += stats_ticks() - start;
+		s.calls++;
+
+		if (n > G.V.size())
+			s.vertices += n - G.V.size();
+		if (m > G.E.size())
+			s.edges += m - G.E.size();
+		if (forced || G.V.size() != n || G.E.size() != m || G.VC.V.size() != vc)
+			s.applied++;
+	}
+
+	// count the call as applied, even if G didn't change
+	void applied() { forced = true; }
+
+private:
+	Graph &G;
+	stat_kind kind;
+	size_t n, m, vc;
+	uint64_t start;
+	bool forced = false;
+};
+#else
+class stat_scope {
+public:
+	stat_scope(Graph &, stat_kind) {};
+	void applied() {};
+};
+#endif
+
+
+/* configurables */
+// file the counters are written to as JSON, empty for none
+extern string STATS_JSON;
+// file the search tree telemetry is written to as CSV, one line per depth
+extern string SEARCH_CSV;
@@ -1,4 +1,49 @@
 #include <chrono>
+#include <cmath>
+
+#include <signal.h>
+#include <sys/time.h>
+
 #include "time.h"
 
 chrono::time_point<chrono::steady_clock> TIME_start;
+atomic<bool> TIME_stop(false);
+
+double TIME_LIMIT       = 0;
+size_t TIME_CHECK_STEPS = 1024;
+
+static void time_signal(int) {
+	TIME_stop.store(true);
+}
+
+void time_init() {
+	struct sigaction sa = {};
+	sa.sa_handler = time_signal;
+	sigemptyset(&sa.sa_mask);
+
+	sigaction(SIGTERM, &sa, nullptr);
+	sigaction(SIGINT,  &sa, nullptr);
+	sigaction(SIGALRM, &sa, nullptr);
+
+	if (TIME_LIMIT > 0) {
+		double secs = TIME_LIMIT - chrono::duration<double>(chrono::steady_clock::now() - TIME_start).count();
+		if (secs <= 0) {
+			TIME_stop.store(true);
+			return;
+		}
+
+		struct itimerval timer = {};
+		timer.it_value.tv_sec  = (time_t) secs;
+		timer.it_value.tv_usec = (suseconds_t) ((secs - floor(secs)) * 1e6);
+		// zero would disarm the timer
+		if (timer.it_value.tv_sec == 0 && timer.it_value.tv_usec == 0)
+			timer.it_value.tv_usec = 1;
+		setitimer(ITIMER_REAL, &timer, nullptr);
+	}
+}
+
+bool time_check_clock() {
+	if (TIME_LIMIT > 0 && chrono::duration<double>(chrono::steady_clock::now() - TIME_start).count() >= TIME_LIMIT)
+		TIME_stop.store(true);
+	return TIME_stop.load(memory_order_relaxed);
+}
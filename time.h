@@ -1,10 +1,38 @@
 #pragma once
 #include <chrono>
+#include <atomic>
+#include <cstddef>
 
 using namespace std;
 
 // global variable
 extern chrono::time_point<chrono::steady_clock> TIME_start;
 
+// set once the search has to stop, by a signal or by time_expired
+extern atomic<bool> TIME_stop;
+
 // max heuristic runtime
 #define TIMEOUT 160.0
+
+/* configurables */
+// seconds after TIME_start the search stops and prints the best cover so far,
+// 0 for no limit
+extern double TIME_LIMIT;
+// branch nodes between two looks at the clock
+extern size_t TIME_CHECK_STEPS;
+
+// stop on SIGTERM, SIGINT and SIGALRM, the latter fires after TIME_LIMIT
+void time_init();
+
+// sets TIME_stop if TIME_LIMIT has passed
+bool time_check_clock();
+
+// cheap enough to call at every branch node, steps is the number of nodes
+// so far
+static inline bool time_expired(size_t steps) {
+	if (TIME_stop.load(memory_order_relaxed))
+		return true;
+	if (steps % TIME_CHECK_STEPS == 0)
+		return time_check_clock();
+	return false;
+}
@@ -15,8 +15,11 @@ void vc_undeg3_apply(Graph &G, Vertex *a, Vertex *b, Vertex *c);
 
 bool vc_undeg3_rule(Graph &G, long long &k) {
 	bool success = false;
-	for (auto it = G.V.begin(); it != G.V.end(); it++) {
-		Vertex *v = *it;
+	// the rule changes G.V, go through a copy
+	vector<Vertex *> todo(G.V.begin(), G.V.end());
+	for (Vertex *v: todo) {
+		if (v->deg == 0)
+			continue;
 		if (vc_undeg3_single(G, v))
 			success = true;
 	}
@@ -123,11 +126,11 @@ void undeg3_delete_edge(Graph &G, GM_undeg3 *op, Edge *e) {
 }
 
 void vc_undeg3_apply(Graph &G, Vertex *a, Vertex *b, Vertex *c) {
-	Vertex *v = new Vertex(G.n, "undeg3_vertex");
+	Vertex *v = arena_new<Vertex>(G.arena, G.n, NO_LABEL);
 	G.n++;
 	bp_vertex_create_callback(G, v);
 
-	GM_undeg3 *op = new GM_undeg3(v, a, b, c);
+	GM_undeg3 *op = arena_new<GM_undeg3>(G.arena, v, a, b, c);
 
 	Vertex *S[] = {a, b, c};
 	vector<Vertex *> marked;
@@ -195,13 +198,15 @@ void vc_undeg3_apply(Graph &G, Vertex *a, Vertex *b, Vertex *c) {
 	for (int i = 0; i < 3; i++) {
 		Vertex *x = S[i];
 
-		Edge *e = new Edge(G.m, v, x);
+		Edge *e = arena_new<Edge>(G.arena, G.m, v, x);
 		G.m++;
 		G.E.push_back(e);
 		auto it = G.E.end();
 		it--;
 		e->iterE = it;
 
+		core_touch(G, x);
+
 		// the Edge constructor increases deg but we don't want that,
 		// rather vert_change_deg should handle it
 		v->deg--;
@@ -223,6 +228,8 @@ void vc_undeg3_apply(Graph &G, Vertex *a, Vertex *b, Vertex *c) {
 		// move edge to the vertex's covered edges
 		move_edge_dirty(e->pos[0], 0, u, u->edges, u->covered);
 		move_edge_dirty(e->pos[1], 1, v, v->edges, v->covered);
+		core_touch(G, u);
+		core_touch(G, v);
 
 		bp_edge_delete_callback(G, e);
 		vert_change_deg(G, u, u->edges.size());
@@ -232,7 +239,7 @@ void vc_undeg3_apply(Graph &G, Vertex *a, Vertex *b, Vertex *c) {
 	}
 
 	// register graph transformation
-	G.changes.push_back(op);
+	trail_push(G, TRAIL_UNDEG3, op);
 }
 
 /******************************************************************************/
@@ -276,10 +283,9 @@ void GM_undeg3::undo(Graph &G) {
 		vert_change_deg(G, a, a->deg - 1);
 		vert_change_deg(G, b, b->deg - 1);
 		bp_edge_delete_callback(G, e);
-		delete e;
 	}
 
-	delete this->v;
+	this->v->~Vertex();
 	G.n--;
 }
 